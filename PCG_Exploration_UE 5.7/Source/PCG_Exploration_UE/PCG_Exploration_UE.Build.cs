@@ -19,7 +19,7 @@ public class PCG_Exploration_UE : ModuleRules
             }
         );
 
-        PrivateDependencyModuleNames.AddRange(new string[] { });
+        PrivateDependencyModuleNames.AddRange(new string[] { "Chaos", "PhysicsCore", "RenderCore", "RHI" });
 
         // Uncomment if you are using Slate UI
         // PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
@@ -1,6 +1,40 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "PCG_Exploration_UE.h"
+#include "TerrainNoise.h"
+#include "TerrainStats.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, PCG_Exploration_UE, "PCG_Exploration_UE" );
+DEFINE_LOG_CATEGORY(LogProceduralTerrain);
+
+DEFINE_STAT(STAT_Terrain_Noise);
+DEFINE_STAT(STAT_Terrain_HeightCache);
+DEFINE_STAT(STAT_Terrain_Erosion);
+DEFINE_STAT(STAT_Terrain_Hydrology);
+DEFINE_STAT(STAT_Terrain_VertexBuild);
+DEFINE_STAT(STAT_Terrain_IndexBuild);
+DEFINE_STAT(STAT_Terrain_Normals);
+DEFINE_STAT(STAT_Terrain_SectionUpload);
+DEFINE_STAT(STAT_Terrain_Collision);
+DEFINE_STAT(STAT_Terrain_Material);
+DEFINE_STAT(STAT_Terrain_Water);
+DEFINE_STAT(STAT_Terrain_Scatter);
+DEFINE_STAT(STAT_Terrain_ScatterCommit);
+
+DEFINE_STAT(STAT_Terrain_Vertices);
+DEFINE_STAT(STAT_Terrain_Triangles);
+DEFINE_STAT(STAT_Terrain_TilesAlive);
+DEFINE_STAT(STAT_Terrain_SectionMemory);
+
+UE_TRACE_CHANNEL_DEFINE(ProceduralTerrainChannel);
+
+class FPCG_Exploration_UEModule : public FDefaultGameModuleImpl
+{
+public:
+    virtual void StartupModule() override
+    {
+        TerrainNoise::WarmUp();
+    }
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FPCG_Exploration_UEModule, PCG_Exploration_UE, "PCG_Exploration_UE" );
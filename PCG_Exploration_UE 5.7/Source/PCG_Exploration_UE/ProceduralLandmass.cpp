@@ -2,22 +2,38 @@
 
 #include "ProceduralLandmass.h"
 
-#include "ProceduralMeshComponent.h"
 #include "Materials/MaterialInterface.h"
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "ProceduralWaterPlane.h"
-#include "EngineUtils.h" // for TActorIterator
+#include "ProceduralTerrainSubsystem.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Async/Async.h"
+#include "Tasks/Task.h"
+#include "Misc/ScopeRWLock.h"
+#include "TerrainMeshBuilder.h"
+#include "TerrainHeightFieldComponent.h"
+#include "TerrainMeshComponent.h"
+#include "TerrainHeightQuery.h"
+#include "TerrainStats.h"
 
 AProceduralLandmass::AProceduralLandmass()
 {
-    PrimaryActorTick.bCanEverTick = false;
+    // Only ticks to pick LODs (enabled in BeginPlay when bEnableLOD is set)
+    // and while scatter instances are being added
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
 
-    ProceduralMesh = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("ProceduralMesh"));
+    ProceduralMesh = CreateDefaultSubobject<UTerrainMeshComponent>(TEXT("ProceduralMesh"));
     RootComponent = ProceduralMesh;
 
     ProceduralMesh->bUseAsyncCooking = true;
+
+    HeightFieldCollision = CreateDefaultSubobject<UTerrainHeightFieldComponent>(TEXT("HeightFieldCollision"));
+    HeightFieldCollision->SetupAttachment(ProceduralMesh);
 }
 
 void AProceduralLandmass::BeginPlay()
@@ -26,11 +42,83 @@ void AProceduralLandmass::BeginPlay()
 
     // Make sure our MID exists and is synced at runtime
     EnsureTerrainMaterialInstance();
+
+    SetActorTickEnabled(bEnableLOD || PendingScatter.IsValid());
+}
+
+void AProceduralLandmass::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    CancelPendingBuild();
+    PendingScatter.Reset();
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void AProceduralLandmass::PostInitializeComponents()
+{
+    Super::PostInitializeComponents();
+
+    if (!bCountedAlive)
+    {
+        bCountedAlive = true;
+        INC_DWORD_STAT(STAT_Terrain_TilesAlive);
+    }
+}
+
+void AProceduralLandmass::BeginDestroy()
+{
+    // Defaults and archetypes are destroyed too but were never counted
+    if (bCountedAlive)
+    {
+        bCountedAlive = false;
+        DEC_DWORD_STAT(STAT_Terrain_TilesAlive);
+    }
+    SetCommittedStats(0, 0, 0);
+
+    Super::BeginDestroy();
+}
+
+void AProceduralLandmass::PostRegisterAllComponents()
+{
+    Super::PostRegisterAllComponents();
+
+    if (UProceduralTerrainSubsystem* TerrainSubsystem = UWorld::GetSubsystem<UProceduralTerrainSubsystem>(GetWorld()))
+    {
+        TerrainSubsystem->RegisterLandmass(this);
+    }
+}
+
+void AProceduralLandmass::PostUnregisterAllComponents()
+{
+    if (UProceduralTerrainSubsystem* TerrainSubsystem = UWorld::GetSubsystem<UProceduralTerrainSubsystem>(GetWorld()))
+    {
+        TerrainSubsystem->UnregisterLandmass(this);
+    }
+
+    Super::PostUnregisterAllComponents();
 }
 
 void AProceduralLandmass::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
+
+    // Scatter instances still queued from the last commit
+    if (PendingScatter.IsValid() && PumpScatterCommit(MaxScatterInstancesPerFrame) && !bEnableLOD)
+    {
+        SetActorTickEnabled(false);
+    }
+
+    if (!bEnableLOD)
+    {
+        return;
+    }
+
+    const UWorld* World = GetWorld();
+    const APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+    if (PC && PC->PlayerCameraManager)
+    {
+        UpdateLOD(PC->PlayerCameraManager->GetCameraLocation(), PC->PlayerCameraManager->GetFOVAngle());
+    }
 }
 
 #if WITH_EDITOR
@@ -42,18 +130,98 @@ void AProceduralLandmass::PostEditChangeProperty(FPropertyChangedEvent& Property
         ? PropertyChangedEvent.Property->GetFName()
         : NAME_None;
 
-    // Geometry / noise changes -> rebuild mesh + refresh material
+    // Rebuild from the first stage the property feeds; the rest follow from it
+    ELandmassBuildStage FirstStage = ELandmassBuildStage::None;
+
     if (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, MapWidth) ||
         PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, MapHeight) ||
-        PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, GridSize) ||
-        PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, HeightMultiplier) ||
         PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, NoiseScale) ||
         PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, Seed) ||
         PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, Octaves) ||
         PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, Persistence) ||
-        PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, Lacunarity))
+        PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, Lacunarity) ||
+        PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, NoiseKernel) ||
+        // Cache hits come back quantized, so switching the cache changes the heights
+        PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, bUseHeightCache) ||
+        // Build-mode switches don't change the output, but they exist to time the noise pass
+        PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, HeightMapBuildMode) ||
+        PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, RowsPerBand) ||
+        PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, bAsyncBuild))
+    {
+        FirstStage = ELandmassBuildStage::Noise;
+    }
+    else if (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionIterations) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionTimeBudgetMs) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionRainRate) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionSedimentCapacity) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionDissolveRate) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionDepositRate) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionEvaporationRate) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionApronCells) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionBorderFalloffCells) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ThermalErosionIterations) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionTalusAngle) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ErosionThermalRate))
+    {
+        FirstStage = ELandmassBuildStage::Erosion;
+    }
+    else if (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, RiverThresholdCells) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, RiverCarveDepth) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, RiverCarveRadius) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, RiverBankSlope) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, RiverPointSpacing) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, RiverBorderFalloffCells) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, MinLakeCells) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, MinLakeDepth) ||
+             // Sea level ends the rivers and floods the lowest basins
+             (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, WaterHeight01) && (RiverThresholdCells > 0 || MinLakeCells > 0)))
+    {
+        FirstStage = ELandmassBuildStage::Hydrology;
+    }
+    else if (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ShorelineRangeCells) ||
+             // The shoreline field follows the water line
+             (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, WaterHeight01) && ShorelineRangeCells > 0))
+    {
+        FirstStage = ELandmassBuildStage::Vertices;
+    }
+    else if (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, HeightMultiplier))
+    {
+        // With erosion on, RebuildStages' cache check sends this back to Erosion
+        FirstStage = ELandmassBuildStage::Heights;
+    }
+    else if (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, GridSize) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, bEnableLOD) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, NumLODs) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, SkirtDepth) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, bAdaptiveTriangulation) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, AdaptiveMaxError))
+    {
+        // GridSize also moves the noise sample origin of a tile away from the
+        // world origin; RebuildStages catches that through the cache check
+        FirstStage = ELandmassBuildStage::Vertices;
+    }
+    else if (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, NormalMode))
+    {
+        FirstStage = ELandmassBuildStage::Normals;
+    }
+    else if (PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, CollisionMode) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, CollisionResolutionStep) ||
+             PropName == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, CollisionLOD))
+    {
+        // Collision comes from the committed heightmap and sections
+        RebuildCollision();
+    }
+
+    // Edits inside a layer report the layer's field, so match on the array itself
+    if (FirstStage == ELandmassBuildStage::None &&
+        PropertyChangedEvent.GetMemberPropertyName() == GET_MEMBER_NAME_CHECKED(AProceduralLandmass, ScatterLayers))
     {
-        GenerateTerrain();
+        FirstStage = ELandmassBuildStage::Scatter;
+    }
+
+    if (FirstStage != ELandmassBuildStage::None)
+    {
+        RebuildStages(TerrainMeshBuilder::StagesFrom(FirstStage));
     }
 
     // Water height changes -> just update material + move any linked water planes
@@ -63,16 +231,29 @@ void AProceduralLandmass::PostEditChangeProperty(FPropertyChangedEvent& Property
         EnsureTerrainMaterialInstance();
 
         // Tell any water planes linked to THIS landmass to realign
-        if (UWorld* World = GetWorld())
+        RefreshLinkedWaterPlanes();
+    }
+}
+
+void AProceduralLandmass::PostEditMove(bool bFinished)
+{
+    Super::PostEditMove(bFinished);
+
+    // Same heights, new placement; queries follow the drag
+    if (const TSharedPtr<const FTerrainHeightQuery, ESPMode::ThreadSafe> Query = GetHeightQuery())
+    {
+        TSharedRef<FTerrainHeightQuery, ESPMode::ThreadSafe> Moved = MakeShared<FTerrainHeightQuery, ESPMode::ThreadSafe>(*Query);
+        Moved->Transform = GetActorTransform();
+
+        FWriteScopeLock Lock(HeightQueryLock);
+        HeightQuery = Moved;
+    }
+
+    if (bFinished)
+    {
+        if (UProceduralTerrainSubsystem* TerrainSubsystem = UWorld::GetSubsystem<UProceduralTerrainSubsystem>(GetWorld()))
         {
-            for (TActorIterator<AProceduralWaterPlane> It(World); It; ++It)
-            {
-                AProceduralWaterPlane* Water = *It;
-                if (Water && Water->LinkedLandmass == this)
-                {
-                    Water->RefreshFromLandmass();
-                }
-            }
+            TerrainSubsystem->RegisterLandmass(this);
         }
     }
 }
@@ -80,12 +261,127 @@ void AProceduralLandmass::PostEditChangeProperty(FPropertyChangedEvent& Property
 
 void AProceduralLandmass::GenerateTerrain()
 {
-    CreateMesh();
-    EnsureTerrainMaterialInstance();
+    RebuildStages(ELandmassBuildStage::All);
+}
+
+void AProceduralLandmass::RebuildStages(ELandmassBuildStage Stages)
+{
+    if (Stages == ELandmassBuildStage::None)
+    {
+        return;
+    }
+
+    // Checked before this request makes the committed result stale too
+    const bool bCommittedIsCurrent = !IsBuildPending();
+
+    // Whatever is in flight was built from settings that no longer apply
+    const int32 Version = BuildVersion->Increment();
+
+    if (!ProceduralMesh || MapWidth < 2 || MapHeight < 2)
+    {
+        return;
+    }
+
+    FLandmassBuildSettings Settings = MakeBuildSettings();
+
+    // Resume after the latest heightmap that is neither invalidated
+    // explicitly nor produced differently by the current settings (actor
+    // location, GridSize off the origin, erosion or hydrology inputs)
+    if (CachedHeightsSettings.IsValid() && !EnumHasAnyFlags(Stages, ELandmassBuildStage::Noise))
+    {
+        const FLandmassBuildSettings& Cached = *CachedHeightsSettings;
+        if (Cached.ProducesSameNoise(Settings))
+        {
+            Settings.CachedNoiseHeights = CachedNoiseHeights;
+
+            if (!EnumHasAnyFlags(Stages, ELandmassBuildStage::Erosion) && Cached.ProducesSameErodedHeightMap(Settings))
+            {
+                Settings.CachedErodedHeights = CachedErodedHeights;
+
+                if (!EnumHasAnyFlags(Stages, ELandmassBuildStage::Hydrology) && Cached.ProducesSameHeightMap(Settings))
+                {
+                    Settings.CachedHeights = CachedHeights;
+                    Settings.CachedHydrology = CachedHydrology;
+                }
+            }
+        }
+    }
+
+    TWeakObjectPtr<AProceduralLandmass> WeakThis(this);
+    TSharedRef<FThreadSafeCounter, ESPMode::ThreadSafe> VersionCounter = BuildVersion;
+
+    // Nothing upstream of scatter changed and the component is current:
+    // place instances on the committed heightmap and leave the mesh alone
+    if (Stages == ELandmassBuildStage::Scatter && bCommittedIsCurrent && Settings.CachedHeights.IsValid())
+    {
+        if (!bAsyncBuild)
+        {
+            CommittedBuildVersion = Version;
+            BeginScatterCommit(TerrainMeshBuilder::BuildScatter(Settings, Settings.CachedHeights));
+            return;
+        }
+
+        UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, VersionCounter, Version, Settings = MoveTemp(Settings)]()
+        {
+            TSharedPtr<const FTerrainScatterResult, ESPMode::ThreadSafe> Scatter = TerrainMeshBuilder::BuildScatter(Settings, Settings.CachedHeights);
+
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, VersionCounter, Version, Scatter]()
+            {
+                AProceduralLandmass* Landmass = WeakThis.Get();
+                if (!Landmass || VersionCounter->GetValue() != Version)
+                {
+                    return;
+                }
+
+                Landmass->CommittedBuildVersion = Version;
+                Landmass->BeginScatterCommit(Scatter);
+            });
+        });
+        return;
+    }
+
+    if (!bAsyncBuild)
+    {
+        FLandmassMeshData Data;
+        if (TerrainMeshBuilder::Build(Settings, Data, [] { return false; }))
+        {
+            CommittedBuildVersion = Version;
+            CommitMeshData(Settings, Data);
+        }
+        return;
+    }
+
+    // Worker stage: heights, vertices, indices and normals from the snapshot.
+    // Commit stage: back on the game thread, only if nothing newer was requested.
+
+    UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, VersionCounter, Version, Settings = MoveTemp(Settings)]()
+    {
+        auto IsStale = [&VersionCounter, Version]() { return VersionCounter->GetValue() != Version; };
+
+        TSharedRef<FLandmassMeshData, ESPMode::ThreadSafe> Data = MakeShared<FLandmassMeshData, ESPMode::ThreadSafe>();
+        if (!TerrainMeshBuilder::Build(Settings, *Data, IsStale))
+        {
+            return;
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, VersionCounter, Version, Settings, Data]()
+        {
+            AProceduralLandmass* Landmass = WeakThis.Get();
+            if (!Landmass || VersionCounter->GetValue() != Version)
+            {
+                return;
+            }
+
+            Landmass->CommittedBuildVersion = Version;
+            Landmass->CommitMeshData(Settings, *Data);
+        });
+    });
 }
 
 void AProceduralLandmass::EnsureTerrainMaterialInstance()
 {
+    TERRAIN_STAGE_SCOPE(Material);
+
     if (!ProceduralMesh)
     {
         return;
@@ -104,7 +400,16 @@ void AProceduralLandmass::EnsureTerrainMaterialInstance()
         }
 
         TerrainMID = UMaterialInstanceDynamic::Create(BaseMat, this);
-        ProceduralMesh->SetMaterial(0, TerrainMID);
+    }
+
+    // Every LOD section shares the one MID
+    const int32 NumMaterialSlots = FMath::Max(ProceduralMesh->GetNumSections(), 1);
+    for (int32 Section = 0; Section < NumMaterialSlots; ++Section)
+    {
+        if (ProceduralMesh->GetMaterial(Section) != TerrainMID)
+        {
+            ProceduralMesh->SetMaterial(Section, TerrainMID);
+        }
     }
 
     // Keep scalar parameters in sync
@@ -126,222 +431,533 @@ FVector AProceduralLandmass::GetLandmassCenter() const
     const float WidthWorld = (MapWidth - 1) * GridSize;
     const float HeightWorld = (MapHeight - 1) * GridSize;
 
-    return GetActorLocation() + FVector(WidthWorld * 0.5f, HeightWorld * 0.5f, 0.0f);
+    return GetActorTransform().TransformPosition(FVector(WidthWorld * 0.5f, HeightWorld * 0.5f, 0.0f));
 }
 
-void AProceduralLandmass::CreateMesh()
+FBox2D AProceduralLandmass::GetWorldBounds2D() const
 {
-    if (!ProceduralMesh || MapWidth < 2 || MapHeight < 2)
+    const FTransform& ActorTransform = GetActorTransform();
+    const double WidthWorld = (MapWidth - 1) * static_cast<double>(GridSize);
+    const double HeightWorld = (MapHeight - 1) * static_cast<double>(GridSize);
+
+    // Box around the four placed corners, so rotated and scaled tiles index correctly
+    FBox2D Bounds(ForceInit);
+    for (const FVector& Corner : { FVector(0.0, 0.0, 0.0), FVector(WidthWorld, 0.0, 0.0), FVector(0.0, HeightWorld, 0.0), FVector(WidthWorld, HeightWorld, 0.0) })
+    {
+        const FVector World = ActorTransform.TransformPosition(Corner);
+        Bounds += FVector2D(World.X, World.Y);
+    }
+    return Bounds;
+}
+
+bool AProceduralLandmass::IsOverGrid(const FVector2D& WorldXY) const
+{
+    const FTransform& ActorTransform = GetActorTransform();
+    const FVector Local = ActorTransform.InverseTransformPosition(FVector(WorldXY.X, WorldXY.Y, ActorTransform.GetLocation().Z));
+
+    return Local.X >= 0.0 && Local.X <= (MapWidth - 1) * static_cast<double>(GridSize)
+        && Local.Y >= 0.0 && Local.Y <= (MapHeight - 1) * static_cast<double>(GridSize);
+}
+
+TSharedPtr<const FTerrainHeightQuery, ESPMode::ThreadSafe> AProceduralLandmass::GetHeightQuery() const
+{
+    FReadScopeLock Lock(HeightQueryLock);
+    return HeightQuery;
+}
+
+bool AProceduralLandmass::GetHeightAtWorldLocation(const FVector& WorldLocation, float& OutHeight) const
+{
+    const TSharedPtr<const FTerrainHeightQuery, ESPMode::ThreadSafe> Query = GetHeightQuery();
+    if (!Query.IsValid() || !Query->IsValid())
+    {
+        return false;
+    }
+
+    const FVector2D WorldXY(WorldLocation.X, WorldLocation.Y);
+    OutHeight = Query->GetHeight(WorldXY);
+    return Query->Contains(WorldXY);
+}
+
+bool AProceduralLandmass::GetNormalAtWorldLocation(const FVector& WorldLocation, FVector& OutNormal) const
+{
+    const TSharedPtr<const FTerrainHeightQuery, ESPMode::ThreadSafe> Query = GetHeightQuery();
+    if (!Query.IsValid() || !Query->IsValid())
+    {
+        return false;
+    }
+
+    const FVector2D WorldXY(WorldLocation.X, WorldLocation.Y);
+    OutNormal = Query->GetNormal(WorldXY);
+    return Query->Contains(WorldXY);
+}
+
+bool AProceduralLandmass::GetHeightsAtWorldLocations(TConstArrayView<FVector2D> WorldXY, TArrayView<float> OutHeights) const
+{
+    const TSharedPtr<const FTerrainHeightQuery, ESPMode::ThreadSafe> Query = GetHeightQuery();
+    if (!Query.IsValid() || !Query->IsValid())
+    {
+        return false;
+    }
+
+    Query->GetHeights(WorldXY, OutHeights);
+    return true;
+}
+
+FLandmassBuildSettings AProceduralLandmass::MakeBuildSettings() const
+{
+    FLandmassBuildSettings Settings;
+    Settings.MapWidth = MapWidth;
+    Settings.MapHeight = MapHeight;
+    Settings.GridSize = GridSize;
+    Settings.HeightMultiplier = HeightMultiplier;
+    Settings.bParallel = (HeightMapBuildMode == ETerrainBuildMode::Parallel);
+    Settings.RowsPerBand = RowsPerBand;
+    Settings.bUseHeightCache = bUseHeightCache;
+    Settings.bCentralDifferenceNormals = (NormalMode == ETerrainNormalMode::CentralDifference);
+    Settings.CollisionStep = (CollisionMode == ETerrainCollisionMode::HeightField) ? FMath::Max(CollisionResolutionStep, 1) : 0;
+    Settings.NumLODs = bEnableLOD ? NumLODs : 1;
+    Settings.SkirtDepth = (bEnableLOD || bAdaptiveTriangulation) ? SkirtDepth : 0.0f;
+    Settings.AdaptiveMaxError = bAdaptiveTriangulation ? AdaptiveMaxError : 0.0f;
+    Settings.WaterLevel01 = WaterHeight01;
+    Settings.ShorelineRangeCells = ShorelineRangeCells;
+    Settings.DebugName = GetName();
+
+    // Layers keep their indices so results line up with ScatterComponents;
+    // a layer without a mesh just produces no points
+    const FVector ActorLocation = GetActorLocation();
+    Settings.Scatter.Seed = Seed;
+    Settings.Scatter.WorldOrigin = FVector2D(ActorLocation.X, ActorLocation.Y);
+    for (const FTerrainScatterLayer& Layer : ScatterLayers)
+    {
+        FTerrainScatterLayerParams& Params = Settings.Scatter.Layers.Emplace_GetRef(Layer);
+        if (!Layer.Mesh)
+        {
+            Params.Density = 0.0f;
+        }
+    }
+
+    FTerrainErosionSettings& Erosion = Settings.Erosion;
+    Erosion.HydraulicIterations = ErosionIterations;
+    Erosion.TimeBudgetMs = ErosionTimeBudgetMs;
+    Erosion.RainRate = ErosionRainRate;
+    Erosion.SedimentCapacity = ErosionSedimentCapacity;
+    Erosion.DissolveRate = ErosionDissolveRate;
+    Erosion.DepositRate = ErosionDepositRate;
+    Erosion.EvaporationRate = ErosionEvaporationRate;
+    Erosion.ThermalIterations = ThermalErosionIterations;
+    Erosion.TalusAngleDegrees = ErosionTalusAngle;
+    Erosion.ThermalRate = ErosionThermalRate;
+    Erosion.ApronCells = ErosionApronCells;
+    Erosion.BorderFalloffCells = ErosionBorderFalloffCells;
+    Erosion.Seed = Seed;
+    Erosion.bParallel = Settings.bParallel;
+    Erosion.RowsPerBand = RowsPerBand;
+
+    FTerrainHydrologySettings& Hydrology = Settings.Hydrology;
+    Hydrology.RiverThresholdCells = RiverThresholdCells;
+    Hydrology.SeaLevel01 = WaterHeight01;
+    Hydrology.MinLakeCells = MinLakeCells;
+    Hydrology.MinLakeDepth01 = MinLakeDepth;
+    Hydrology.CarveDepth01 = RiverCarveDepth;
+    Hydrology.CarveRadiusCells = RiverCarveRadius;
+    Hydrology.BankSlope = RiverBankSlope;
+    Hydrology.PointSpacingCells = RiverPointSpacing;
+    Hydrology.BorderFalloffCells = RiverBorderFalloffCells;
+    Hydrology.bParallel = Settings.bParallel;
+    Hydrology.RowsPerBand = RowsPerBand;
+
+    Settings.bFlatHeightMap = (NoiseScale <= KINDA_SMALL_NUMBER);
+    if (Settings.bFlatHeightMap)
+    {
+        return Settings;
+    }
+
+    // --- NEW: compute world-aligned base coordinates for this tile ---
+    // Convert the actor's world location into "grid steps"
+    const float InvGridSize = (GridSize > 0.0f) ? (1.0f / GridSize) : 0.0f;
+    const FVector ActorLoc = GetActorLocation();
+
+    FTerrainNoiseSampler& Sampler = Settings.Noise;
+    Sampler.MapWidth = MapWidth;
+    Sampler.BaseWorldX = ActorLoc.X * InvGridSize;
+    Sampler.BaseWorldY = ActorLoc.Y * InvGridSize;
+    Sampler.NoiseScale = NoiseScale;
+    Sampler.Octaves = Octaves;
+    Sampler.Persistence = Persistence;
+    Sampler.Lacunarity = Lacunarity;
+    Sampler.bUseVectorKernel = (NoiseKernel == ETerrainNoiseKernel::Vector) && TerrainNoise::IsVectorKernelAvailable();
+    // ---------------------------------------------------------------
+
+    FRandomStream Rng(Seed);
+    Sampler.Offset = FVector2D(
+        Rng.FRandRange(-10000.f, 10000.f),
+        Rng.FRandRange(-10000.f, 10000.f)
+    );
+
+    return Settings;
+}
+
+void AProceduralLandmass::CommitMeshData(const FLandmassBuildSettings& Settings, const FLandmassMeshData& Data)
+{
+    check(IsInGameThread());
+
+    if (!ProceduralMesh)
     {
         return;
     }
 
-    const int32 NumVertsX = MapWidth;
-    const int32 NumVertsY = MapHeight;
-    const int32 NumVerts = NumVertsX * NumVertsY;
+    // Inclusive of the collision, material and water updates below, which also have their own stats
+    TERRAIN_STAGE_SCOPE(SectionUpload);
+
+    // Keep only the noise key; the copy must not hold on to older heights
+    TSharedRef<FLandmassBuildSettings, ESPMode::ThreadSafe> HeightsKey = MakeShared<FLandmassBuildSettings, ESPMode::ThreadSafe>(Settings);
+    HeightsKey->CachedHeights.Reset();
+    HeightsKey->CachedHydrology.Reset();
+    HeightsKey->CachedNoiseHeights.Reset();
+    HeightsKey->CachedErodedHeights.Reset();
+    CachedHeightsSettings = HeightsKey;
+    CachedHeights = Data.Heights;
+    CachedHydrology = Data.Hydrology;
+    CachedNoiseHeights = Data.NoiseHeights;
+    CachedErodedHeights = Data.ErodedHeights;
+
+    // Rivers come out relative to heightmap sample (0, 0), which is the actor
+    Rivers.Reset();
+    NumLakes = Data.Hydrology.IsValid() ? Data.Hydrology->Lakes.Num() : 0;
+    if (Data.Hydrology.IsValid())
+    {
+        const FTransform& ActorTransform = GetActorTransform();
+        for (const FTerrainRiverPath& Path : Data.Hydrology->Rivers)
+        {
+            FTerrainRiver& River = Rivers.AddDefaulted_GetRef();
+            River.Flow = Path.Flow;
+            River.Points.Reserve(Path.Points.Num());
+            for (const FVector3f& Point : Path.Points)
+            {
+                River.Points.Add(ActorTransform.TransformPosition(FVector(Point)));
+            }
+        }
+    }
 
-    TArray<FVector>          Vertices;
-    TArray<int32>            Triangles;
-    TArray<FVector>          Normals;
-    TArray<FVector2D>        UVs;
-    TArray<FLinearColor>     VertexColors;
-    TArray<FProcMeshTangent> Tangents;
+    TSharedRef<FTerrainHeightQuery, ESPMode::ThreadSafe> NewHeightQuery = MakeShared<FTerrainHeightQuery, ESPMode::ThreadSafe>();
+    NewHeightQuery->Heights = Data.Heights;
+    NewHeightQuery->Transform = GetActorTransform();
+    NewHeightQuery->MapWidth = Settings.MapWidth;
+    NewHeightQuery->MapHeight = Settings.MapHeight;
+    NewHeightQuery->GridSize = Settings.GridSize;
+    NewHeightQuery->HeightMultiplier = Settings.HeightMultiplier;
+    {
+        FWriteScopeLock Lock(HeightQueryLock);
+        HeightQuery = NewHeightQuery;
+    }
 
-    Vertices.SetNum(NumVerts);
-    Normals.SetNum(NumVerts);
-    UVs.SetNum(NumVerts);
-    VertexColors.SetNum(NumVerts);
-    Tangents.SetNum(NumVerts);
+    const int32 NumBuiltLODs = Data.LODs.Num();
+    // Heightfield mode: no section cooks collision
+    const bool bHeightFieldCollision = (Data.Collision.NumX > 0);
+    const int32 CollisionSection = bHeightFieldCollision ? INDEX_NONE : FMath::Clamp(CollisionLOD, 0, NumBuiltLODs - 1);
 
-    // Build height map
-    TArray<float> Heights;
-    BuildHeightMap(Heights);
+    LODTriangleCounts.Reset(NumBuiltLODs);
+    LODGeometricErrors.Reset(NumBuiltLODs);
 
-    // --- Build vertices, UVs, vertex colors, tangents ---
-    for (int32 y = 0; y < NumVertsY; ++y)
+    // --- Hand one section per LOD to the component ---
+    // The component keeps the built section itself. Same index buffer as the
+    // section already there means only vertex data changed, so the proxy
+    // refills its vertex buffers in place instead of being recreated.
+    for (int32 LOD = 0; LOD < NumBuiltLODs; ++LOD)
     {
-        for (int32 x = 0; x < NumVertsX; ++x)
+        const FLandmassMeshSection& Section = *Data.LODs[LOD];
+
+        const UTerrainMeshComponent::FSectionPtr Committed = ProceduralMesh->GetSection(LOD);
+        if (Committed.IsValid() && Committed->Triangles == Section.Triangles)
         {
-            const int32 Index = y * NumVertsX + x;
+            ProceduralMesh->UpdateSectionVertices(LOD, Data.LODs[LOD]);
+        }
+        else
+        {
+            ProceduralMesh->SetSection(LOD, Data.LODs[LOD]);
+        }
+
+        LODTriangleCounts.Add(Section.NumSurfaceTriangles);
+        LODGeometricErrors.Add(Section.GeometricError);
 
-            const float Height01 = Heights.IsValidIndex(Index) ? Heights[Index] : 0.0f;
-            const float Z = Height01 * HeightMultiplier;
+        if (NumBuiltLODs > 1)
+        {
+            UE_LOG(LogProceduralTerrain, Log, TEXT("%s: LOD%d %d triangles (%.1f%% of LOD0), geometric error %.1f"),
+                *GetName(), LOD, Section.NumSurfaceTriangles,
+                100.0f * Section.NumSurfaceTriangles / FMath::Max(Data.LODs[0]->NumSurfaceTriangles, 1),
+                Section.GeometricError);
+        }
+    }
 
-            // Position
-            Vertices[Index] = FVector(x * GridSize, y * GridSize, Z);
+    // Drop levels left over from a build with more LODs
+    ProceduralMesh->SetNumSections(NumBuiltLODs);
 
-            // UVs in [0,1]
-            const float U = (NumVertsX > 1) ? (static_cast<float>(x) / (NumVertsX - 1)) : 0.0f;
-            const float V = (NumVertsY > 1) ? (static_cast<float>(y) / (NumVertsY - 1)) : 0.0f;
-            UVs[Index] = FVector2D(U, V);
+    // Recooks only if the collision section or its data changed
+    ProceduralMesh->SetCollisionSection(CollisionSection);
 
-            // Height-only in B channel (0..1), R/G free for future use
-            VertexColors[Index] = FLinearColor(
-                0.0f,      // R - reserved (biome)
-                0.0f,      // G - reserved (slope)
-                Height01,  // B - normalized height
-                1.0f       // A - wetness/whatever later
-            );
+    uint32 NumVertices = 0;
+    uint32 NumTriangles = 0;
+    for (const TSharedPtr<FLandmassMeshSection, ESPMode::ThreadSafe>& Section : Data.LODs)
+    {
+        NumVertices += Section->Positions.Num();
+        NumTriangles += Section->NumSurfaceTriangles;
+    }
 
-            // Simple tangent along +X
-            Tangents[Index] = FProcMeshTangent(1.0f, 0.0f, 0.0f);
+    // The sections the component now shares with Data; its GPU buffers are not counted
+    SetCommittedStats(NumVertices, NumTriangles, ProceduralMesh->GetSectionMemory());
 
-            // Initialize normals to zero; well accumulate face normals then normalize
-            Normals[Index] = FVector::ZeroVector;
+    if (HeightFieldCollision)
+    {
+        if (bHeightFieldCollision)
+        {
+            HeightFieldCollision->SetHeightField(Data.Collision);
+        }
+        else if (HeightFieldCollision->HasHeightField())
+        {
+            HeightFieldCollision->ClearHeightField();
         }
     }
 
-    // --- Build triangle indices ---
-    const int32 NumQuadsX = NumVertsX - 1;
-    const int32 NumQuadsY = NumVertsY - 1;
-    Triangles.Reserve(NumQuadsX * NumQuadsY * 6);
+    SetVisibleLOD(FMath::Clamp(CurrentLOD, 0, NumBuiltLODs - 1));
 
-    for (int32 y = 0; y < NumQuadsY; ++y)
+    EnsureTerrainMaterialInstance();
+
+    BeginScatterCommit(Data.Scatter);
+
+    // Tiles are moved before they rebuild, so re-index with the committed extent
+    if (UProceduralTerrainSubsystem* TerrainSubsystem = UWorld::GetSubsystem<UProceduralTerrainSubsystem>(GetWorld()))
     {
-        for (int32 x = 0; x < NumQuadsX; ++x)
+        TerrainSubsystem->RegisterLandmass(this);
+    }
+
+    // Submerged-only water follows the new heightmap
+    RefreshLinkedWaterPlanes();
+
+    OnTerrainBuilt.Broadcast(this);
+}
+
+void AProceduralLandmass::BeginScatterCommit(const TSharedPtr<const FTerrainScatterResult, ESPMode::ThreadSafe>& Scatter)
+{
+    TERRAIN_STAGE_SCOPE(ScatterCommit);
+
+    const int32 NumLayers = Scatter.IsValid() ? Scatter->Instances.Num() : 0;
+
+    // Components of layers that no longer exist go away
+    while (ScatterComponents.Num() > NumLayers)
+    {
+        if (UHierarchicalInstancedStaticMeshComponent* Component = ScatterComponents.Pop())
         {
-            const int32 BottomLeft = y * NumVertsX + x;
-            const int32 BottomRight = BottomLeft + 1;
-            const int32 TopLeft = BottomLeft + NumVertsX;
-            const int32 TopRight = TopLeft + 1;
-
-            // First tri: TopLeft, BottomRight, BottomLeft
-            Triangles.Add(TopLeft);
-            Triangles.Add(BottomRight);
-            Triangles.Add(BottomLeft);
-
-            // Second tri: TopLeft, TopRight, BottomRight
-            Triangles.Add(TopLeft);
-            Triangles.Add(TopRight);
-            Triangles.Add(BottomRight);
+            Component->DestroyComponent();
         }
     }
+    ScatterComponents.SetNumZeroed(NumLayers);
+    ScatterInstanceCounts.SetNumZeroed(NumLayers);
 
-    // --- Compute normals from triangles ---
-    const int32 NumTris = Triangles.Num() / 3;
-    for (int32 i = 0; i < NumTris; ++i)
+    for (int32 Layer = 0; Layer < NumLayers; ++Layer)
     {
-        const int32 I0 = Triangles[i * 3 + 0];
-        const int32 I1 = Triangles[i * 3 + 1];
-        const int32 I2 = Triangles[i * 3 + 2];
+        UHierarchicalInstancedStaticMeshComponent*& Component = ScatterComponents[Layer];
+        if (!Component)
+        {
+            Component = NewObject<UHierarchicalInstancedStaticMeshComponent>(this, NAME_None, RF_Transient);
+            Component->SetupAttachment(ProceduralMesh);
+            Component->RegisterComponent();
+            AddInstanceComponent(Component);
+        }
+
+        const FTerrainScatterLayer* Desc = ScatterLayers.IsValidIndex(Layer) ? &ScatterLayers[Layer] : nullptr;
 
-        const FVector& V0 = Vertices[I0];
-        const FVector& V1 = Vertices[I1];
-        const FVector& V2 = Vertices[I2];
+        Component->ClearInstances();
+        Component->SetStaticMesh(Desc ? Desc->Mesh : nullptr);
+        Component->SetCullDistances(0, Desc ? Desc->CullDistance : 0);
+        Component->SetCollisionEnabled((Desc && Desc->bCollision) ? ECollisionEnabled::QueryAndPhysics : ECollisionEnabled::NoCollision);
 
-        const FVector Edge1 = V1 - V0;
-        const FVector Edge2 = V2 - V0;
-        const FVector Normal = FVector::CrossProduct(Edge2, Edge1).GetSafeNormal();
+        ScatterInstanceCounts[Layer] = Scatter->Instances[Layer].Num();
+    }
+
+    PendingScatter = (NumLayers > 0) ? Scatter : nullptr;
+    PendingScatterLayer = 0;
+    PendingScatterIndex = 0;
 
-        Normals[I0] += Normal;
-        Normals[I1] += Normal;
-        Normals[I2] += Normal;
+    if (!PendingScatter.IsValid())
+    {
+        return;
+    }
+
+    // Editor worlds don't tick actors, so they take everything now
+    const UWorld* World = GetWorld();
+    if (World && World->IsGameWorld())
+    {
+        SetActorTickEnabled(true);
+    }
+    else
+    {
+        PumpScatterCommit(MAX_int32);
+    }
+}
+
+bool AProceduralLandmass::PumpScatterCommit(int32 Budget)
+{
+    if (!PendingScatter.IsValid())
+    {
+        return true;
     }
 
-    for (int32 i = 0; i < NumVerts; ++i)
+    TERRAIN_STAGE_SCOPE(ScatterCommit);
+
+    TArray<FTransform> Batch;
+    const int32 NumLayers = PendingScatter->Instances.Num();
+
+    while (Budget > 0 && PendingScatterLayer < NumLayers)
     {
-        FVector& N = Normals[i];
+        const TArray<FTransform>& Instances = PendingScatter->Instances[PendingScatterLayer];
+        UHierarchicalInstancedStaticMeshComponent* Component = ScatterComponents.IsValidIndex(PendingScatterLayer) ? ScatterComponents[PendingScatterLayer] : nullptr;
 
-        if (!N.IsNearlyZero())
+        const int32 Count = FMath::Min(Budget, Instances.Num() - PendingScatterIndex);
+        if (Component && Component->GetStaticMesh() && Count > 0)
         {
-            N.Normalize();
+            Batch.Reset(Count);
+            Batch.Append(Instances.GetData() + PendingScatterIndex, Count);
+
+            // Component space; navigation is left alone, trees don't carve the navmesh here
+            Component->AddInstances(Batch, false, false, false);
+
+            PendingScatterIndex += Count;
+            Budget -= Count;
         }
         else
         {
-            N = FVector::UpVector;
+            PendingScatterIndex = Instances.Num();
         }
 
-        // Extra safety against NaNs/Infs
-        if (!FMath::IsFinite(N.X) || !FMath::IsFinite(N.Y) || !FMath::IsFinite(N.Z))
+        if (PendingScatterIndex >= Instances.Num())
         {
-            N = FVector::UpVector;
+            ++PendingScatterLayer;
+            PendingScatterIndex = 0;
         }
     }
 
-    // --- Push mesh to the component ---
-    ProceduralMesh->CreateMeshSection_LinearColor(
-        0,
-        Vertices,
-        Triangles,
-        Normals,
-        UVs,
-        VertexColors,
-        Tangents,
-        true  // bCreateCollision
-    );
+    if (PendingScatterLayer < NumLayers)
+    {
+        return false;
+    }
+
+    PendingScatter.Reset();
+    return true;
 }
 
-void AProceduralLandmass::BuildHeightMap(TArray<float>& OutHeights) const
+void AProceduralLandmass::RefreshLinkedWaterPlanes()
 {
-    const int32 NumVerts = MapWidth * MapHeight;
-    OutHeights.SetNum(NumVerts);
+    const UProceduralTerrainSubsystem* TerrainSubsystem = UWorld::GetSubsystem<UProceduralTerrainSubsystem>(GetWorld());
+    if (!TerrainSubsystem)
+    {
+        return;
+    }
 
-    if (NoiseScale <= KINDA_SMALL_NUMBER)
+    // Copied, since a refresh may relink the plane
+    const TArray<AProceduralWaterPlane*, TInlineAllocator<4>> WaterPlanes = TerrainSubsystem->GetLinkedWaterPlanes(this);
+    for (AProceduralWaterPlane* Water : WaterPlanes)
     {
-        for (int32 i = 0; i < NumVerts; ++i)
+        if (IsValid(Water))
         {
-            OutHeights[i] = 0.0f;
+            Water->RefreshFromLandmass();
         }
-        return;
     }
+}
 
-    // --- NEW: compute world-aligned base coordinates for this tile ---
-    // Convert the actor's world location into "grid steps"
-    const float InvGridSize = (GridSize > 0.0f) ? (1.0f / GridSize) : 0.0f;
-    const FVector ActorLoc = GetActorLocation();
+void AProceduralLandmass::SetCommittedStats(uint32 NumVertices, uint32 NumTriangles, SIZE_T NumBytes)
+{
+    // Swap this landmass's contribution to the module-wide totals
+    DEC_DWORD_STAT_BY(STAT_Terrain_Vertices, StatVertices);
+    DEC_DWORD_STAT_BY(STAT_Terrain_Triangles, StatTriangles);
+    DEC_MEMORY_STAT_BY(STAT_Terrain_SectionMemory, StatBytes);
+
+    StatVertices = NumVertices;
+    StatTriangles = NumTriangles;
+    StatBytes = NumBytes;
+
+    INC_DWORD_STAT_BY(STAT_Terrain_Vertices, StatVertices);
+    INC_DWORD_STAT_BY(STAT_Terrain_Triangles, StatTriangles);
+    INC_MEMORY_STAT_BY(STAT_Terrain_SectionMemory, StatBytes);
+}
 
-    const float BaseWorldX = ActorLoc.X * InvGridSize;
-    const float BaseWorldY = ActorLoc.Y * InvGridSize;
-    // ---------------------------------------------------------------
+void AProceduralLandmass::UpdateLOD(const FVector& ViewLocation, float FOVDegrees)
+{
+    const int32 NumBuiltLODs = LODGeometricErrors.Num();
+    if (NumBuiltLODs <= 1 || !ProceduralMesh)
+    {
+        return;
+    }
 
-    FRandomStream Rng(Seed);
-    const FVector2D Offset(
-        Rng.FRandRange(-10000.f, 10000.f),
-        Rng.FRandRange(-10000.f, 10000.f)
-    );
+    // Distance to the tile bounds, so the tile under the camera always gets LOD0
+    const FBox Bounds = ProceduralMesh->Bounds.GetBox();
+    const float Distance = FMath::Max(FMath::Sqrt(Bounds.ComputeSquaredDistanceToPoint(ViewLocation)), 1.0f);
+
+    // Pixels covered by one world unit at distance 1
+    const float HalfFOV = FMath::DegreesToRadians(FMath::Clamp(FOVDegrees, 1.0f, 170.0f) * 0.5f);
+    const float PixelsPerUnit = LODReferenceScreenHeight / (2.0f * FMath::Tan(HalfFOV));
 
-    for (int32 y = 0; y < MapHeight; ++y)
+    int32 NewLOD = 0;
+    for (int32 LOD = NumBuiltLODs - 1; LOD > 0; --LOD)
     {
-        for (int32 x = 0; x < MapWidth; ++x)
+        const float ProjectedError = LODGeometricErrors[LOD] * PixelsPerUnit / Distance;
+        if (ProjectedError <= MaxScreenSpaceError)
         {
-            const int32 Index = y * MapWidth + x;
+            NewLOD = LOD;
+            break;
+        }
+    }
 
-            // --- NEW: world-aligned grid coordinates for this vertex ---
-            const float WorldGridX = BaseWorldX + static_cast<float>(x);
-            const float WorldGridY = BaseWorldY + static_cast<float>(y);
+    if (NewLOD != CurrentLOD)
+    {
+        SetVisibleLOD(NewLOD);
+    }
+}
 
-            const float SampleX = (WorldGridX + Offset.X) / NoiseScale;
-            const float SampleY = (WorldGridY + Offset.Y) / NoiseScale;
-            // -----------------------------------------------------------
+void AProceduralLandmass::RebuildCollision()
+{
+    const int32 NumSections = ProceduralMesh ? ProceduralMesh->GetNumSections() : 0;
 
-            float NoiseHeight = 0.0f;
-            float Amplitude = 1.0f;
-            float Frequency = 1.0f;
-            float MaxPossible = 0.0f;
+    // The committed heightmap and sections only describe the current
+    // settings when nothing else is on its way
+    if (IsBuildPending() || !CachedHeights.IsValid() || NumSections == 0)
+    {
+        RebuildStages(TerrainMeshBuilder::StagesFrom(ELandmassBuildStage::Vertices));
+        return;
+    }
 
-            for (int32 Oct = 0; Oct < Octaves; ++Oct)
-            {
-                const float Px = SampleX * Frequency;
-                const float Py = SampleY * Frequency;
+    const FLandmassBuildSettings Settings = MakeBuildSettings();
+    const bool bHeightFieldCollision = (Settings.CollisionStep > 0);
 
-                const float Perlin = FMath::PerlinNoise2D(FVector2D(Px, Py));
-                NoiseHeight += Perlin * Amplitude;
+    if (HeightFieldCollision)
+    {
+        if (bHeightFieldCollision)
+        {
+            FLandmassCollisionHeightField HeightField;
+            TerrainMeshBuilder::BuildCollisionHeightField(Settings, *CachedHeights, HeightField);
+            HeightFieldCollision->SetHeightField(HeightField);
+        }
+        else if (HeightFieldCollision->HasHeightField())
+        {
+            HeightFieldCollision->ClearHeightField();
+        }
+    }
 
-                MaxPossible += Amplitude;
-                Amplitude *= Persistence;
-                Frequency *= Lacunarity;
-            }
+    // The component cooks from the section it already holds
+    ProceduralMesh->SetCollisionSection(bHeightFieldCollision ? INDEX_NONE : FMath::Clamp(CollisionLOD, 0, NumSections - 1));
+}
 
-            if (MaxPossible > 0.0f)
-            {
-                NoiseHeight = (NoiseHeight / MaxPossible) * 0.5f + 0.5f;
-            }
-            else
-            {
-                NoiseHeight = 0.0f;
-            }
+void AProceduralLandmass::SetVisibleLOD(int32 LOD)
+{
+    CurrentLOD = LOD;
 
-            OutHeights[Index] = FMath::Clamp(NoiseHeight, 0.0f, 1.0f);
-        }
+    for (int32 Section = 0; Section < ProceduralMesh->GetNumSections(); ++Section)
+    {
+        ProceduralMesh->SetSectionVisible(Section, Section == LOD);
     }
 }
+
+void AProceduralLandmass::CancelPendingBuild()
+{
+    // Any build that captured an older version drops its result
+    BuildVersion->Increment();
+}
@@ -2,11 +2,58 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "TerrainHydrology.h"
+#include "TerrainScatter.h"
 #include "ProceduralLandmass.generated.h"
 
-class UProceduralMeshComponent;
+class UTerrainMeshComponent;
+class UTerrainHeightFieldComponent;
+class UHierarchicalInstancedStaticMeshComponent;
 class UMaterialInterface;
 class UMaterialInstanceDynamic;
+class AProceduralLandmass;
+struct FLandmassBuildSettings;
+struct FLandmassMeshData;
+struct FTerrainHeightQuery;
+struct FTerrainScatterResult;
+struct FTerrainHydrologyResult;
+enum class ELandmassBuildStage : uint8;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnLandmassBuilt, AProceduralLandmass*, Landmass);
+
+// How the heightmap stage distributes noise evaluation. Both modes produce identical heights.
+UENUM(BlueprintType)
+enum class ETerrainBuildMode : uint8
+{
+    Serial,     // Every row on the calling thread
+    Parallel    // Row bands spread across the task graph
+};
+
+// Which Perlin implementation the heightmap stage uses
+UENUM(BlueprintType)
+enum class ETerrainNoiseKernel : uint8
+{
+    Scalar,     // One FMath::PerlinNoise2D call per octave per vertex
+    Vector      // 4 samples per instruction (SSE/NEON); matches Scalar within TerrainNoise::VectorKernelTolerance
+};
+
+// How vertex normals are derived
+UENUM(BlueprintType)
+enum class ETerrainNormalMode : uint8
+{
+    TriangleAccumulate,  // Sum of adjacent face normals, normalized per vertex
+    CentralDifference    // Heightmap slope at each vertex, written in the vertex pass
+};
+
+// What the landmass collides with
+UENUM(BlueprintType)
+enum class ETerrainCollisionMode : uint8
+{
+    TriangleMesh,   // Cooked from the CollisionLOD section
+    HeightField     // Chaos heightfield built from the heightmap, no cooking
+};
 
 UCLASS()
 class PCG_EXPLORATION_UE_API AProceduralLandmass : public AActor
@@ -17,19 +64,90 @@ public:
     AProceduralLandmass();
 
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     virtual void Tick(float DeltaTime) override;
 
+    // Tiles Alive counts every initialized landmass, editor ones included,
+    // until it is destroyed
+    virtual void PostInitializeComponents() override;
+    virtual void BeginDestroy() override;
+
+    // Registration with UProceduralTerrainSubsystem follows component registration
+    virtual void PostRegisterAllComponents() override;
+    virtual void PostUnregisterAllComponents() override;
+
 #if WITH_EDITOR
     virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+    virtual void PostEditMove(bool bFinished) override;
 #endif
 
     // ------------ Runtime helpers ------------
     float   GetDefaultWaterHeight01() const;
     FVector GetLandmassCenter() const;
 
+    // World XY box around the placed heightmap grid
+    FBox2D GetWorldBounds2D() const;
+
+    // True when the world XY location lies over the placed heightmap grid (edges included)
+    bool IsOverGrid(const FVector2D& WorldXY) const;
+
+    // Rebuilds the mesh from the current settings. With bAsyncBuild the heavy
+    // work runs on a worker and only the section upload happens on the game thread.
+    UFUNCTION(CallInEditor, BlueprintCallable, Category = "Terrain")
+    void GenerateTerrain();
+
+    // Reruns the given stages and everything downstream of them, resuming
+    // from the cached noise, eroded or final heightmap when its stage isn't
+    // listed and the current settings still produce it. A Scatter-only
+    // rebuild places instances on the committed heightmap without touching
+    // the mesh.
+    void RebuildStages(ELandmassBuildStage Stages);
+
+    // Applies CollisionMode, CollisionResolutionStep and CollisionLOD to the
+    // committed mesh without rebuilding it
+    void RebuildCollision();
+
+    // Drops any in-flight async build without committing it
+    void CancelPendingBuild();
+
+    // Normalized [0..1] heightmap of the last committed build, MapWidth x MapHeight,
+    // row-major. Null before the first build.
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> GetCachedHeightMap() const { return CachedHeights; }
+
+    // Lakes and rivers found with that heightmap; null when the Rivers and
+    // Lakes settings are both off
+    TSharedPtr<const FTerrainHydrologyResult, ESPMode::ThreadSafe> GetHydrology() const { return CachedHydrology; }
+
+    // ------------ Height queries ------------
+    // Heightmap sampling instead of physics traces. All of these may be called
+    // from any thread and answer from the last committed build; before the
+    // first build they return false (or a null snapshot).
+
+    // Snapshot to keep for many queries, e.g. for the length of a worker task
+    TSharedPtr<const FTerrainHeightQuery, ESPMode::ThreadSafe> GetHeightQuery() const;
+
+    // World Z of the surface under WorldLocation's XY. False when there is no
+    // heightmap yet or the point is off this tile (OutHeight then holds the edge height).
+    UFUNCTION(BlueprintPure, Category = "Terrain")
+    bool GetHeightAtWorldLocation(const FVector& WorldLocation, float& OutHeight) const;
+
+    UFUNCTION(BlueprintPure, Category = "Terrain")
+    bool GetNormalAtWorldLocation(const FVector& WorldLocation, FVector& OutNormal) const;
+
+    // OutHeights[i] is the surface Z under WorldXY[i]; false when there is no heightmap yet
+    bool GetHeightsAtWorldLocations(TConstArrayView<FVector2D> WorldXY, TArrayView<float> OutHeights) const;
+
+    // Fired on the game thread after a build has been committed to the mesh
+    UPROPERTY(BlueprintAssignable, Category = "Terrain")
+    FOnLandmassBuilt OnTerrainBuilt;
+
     // ------------ Components ------------
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Terrain")
-    UProceduralMeshComponent* ProceduralMesh = nullptr;
+    UTerrainMeshComponent* ProceduralMesh = nullptr;
+
+    // Only has a body in HeightField collision mode
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Terrain")
+    UTerrainHeightFieldComponent* HeightFieldCollision = nullptr;
 
     // ------------ Terrain settings ------------
     UPROPERTY(EditAnywhere, Category = "Terrain|Dimensions")
@@ -65,17 +183,260 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Terrain")
     FVector2D TileOffset = FVector2D(0, 0);
 
+    // ------------ Build ------------
+    // Build geometry on a worker thread; only the mesh commit runs on the game thread
+    UPROPERTY(EditAnywhere, Category = "Terrain|Build")
+    bool bAsyncBuild = true;
+
+    UPROPERTY(EditAnywhere, Category = "Terrain|Build")
+    ETerrainBuildMode HeightMapBuildMode = ETerrainBuildMode::Parallel;
+
+    // Rows handed to each task in Parallel mode
+    UPROPERTY(EditAnywhere, Category = "Terrain|Build", meta = (ClampMin = "1", EditCondition = "HeightMapBuildMode == ETerrainBuildMode::Parallel"))
+    int32 RowsPerBand = 16;
+
+    UPROPERTY(EditAnywhere, Category = "Terrain|Build")
+    ETerrainNoiseKernel NoiseKernel = ETerrainNoiseKernel::Vector;
+
+    UPROPERTY(EditAnywhere, Category = "Terrain|Build")
+    ETerrainNormalMode NormalMode = ETerrainNormalMode::CentralDifference;
+
+    // Reuse heightmaps saved under Saved/TerrainCache by earlier runs. Cached
+    // heights are quantized to TerrainHeightCache::QuantizationStep.
+    UPROPERTY(EditAnywhere, Category = "Terrain|Build")
+    bool bUseHeightCache = true;
+
+    // ------------ Erosion ------------
+    // Hydraulic erosion steps run on the heightmap before meshing (0 = off)
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0"))
+    int32 ErosionIterations = 0;
+
+    // Stops erosion early on slow machines (0 = no limit). Tiles cut short
+    // differ between runs and may not match their neighbours at the seams.
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0.0", EditCondition = "ErosionIterations > 0 || ThermalErosionIterations > 0"))
+    float ErosionTimeBudgetMs = 0.0f;
+
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0.0", EditCondition = "ErosionIterations > 0"))
+    float ErosionRainRate = 0.012f;
+
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0.0", EditCondition = "ErosionIterations > 0"))
+    float ErosionSedimentCapacity = 1.0f;
+
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0.0", EditCondition = "ErosionIterations > 0"))
+    float ErosionDissolveRate = 0.5f;
+
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0.0", EditCondition = "ErosionIterations > 0"))
+    float ErosionDepositRate = 1.0f;
+
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0.0", EditCondition = "ErosionIterations > 0"))
+    float ErosionEvaporationRate = 0.015f;
+
+    // Neighbouring terrain simulated around the tile, in heightmap cells
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0", EditCondition = "ErosionIterations > 0 || ThermalErosionIterations > 0"))
+    int32 ErosionApronCells = 16;
+
+    // Cells over which erosion fades in from the tile border. The outer two
+    // rings stay raw regardless, since neighbouring tiles sample them as their
+    // apron; the erosion apron already simulates the flow across the border,
+    // so a short fade is enough. Expect a less eroded band this many cells
+    // plus one wide along every tile edge (3 at the default of 2)
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "1", EditCondition = "ErosionIterations > 0 || ThermalErosionIterations > 0"))
+    int32 ErosionBorderFalloffCells = 2;
+
+    // Talus relaxation steps after the hydraulic ones (0 = off); flattens the
+    // spikes high Lacunarity values leave
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0"))
+    int32 ThermalErosionIterations = 0;
+
+    // Steepest slope that holds; anything steeper slides down
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0.0", ClampMax = "89.0", EditCondition = "ThermalErosionIterations > 0"))
+    float ErosionTalusAngle = 40.0f;
+
+    // Fraction of the excess slope moved per step
+    UPROPERTY(EditAnywhere, Category = "Terrain|Erosion", meta = (ClampMin = "0.01", ClampMax = "1.0", EditCondition = "ThermalErosionIterations > 0"))
+    float ErosionThermalRate = 0.5f;
+
+    // ------------ Rivers ------------
+    // Heightmap cells that must drain through a cell before it becomes a river (0 = no drainage analysis)
+    UPROPERTY(EditAnywhere, Category = "Terrain|Rivers", meta = (ClampMin = "0"))
+    int32 RiverThresholdCells = 0;
+
+    // Normalized channel depth of large rivers; small ones are cut in less (0 = trace only)
+    UPROPERTY(EditAnywhere, Category = "Terrain|Rivers", meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "RiverThresholdCells > 0"))
+    float RiverCarveDepth = 0.01f;
+
+    // Bank width in heightmap cells either side of the channel
+    UPROPERTY(EditAnywhere, Category = "Terrain|Rivers", meta = (ClampMin = "0", ClampMax = "8", EditCondition = "RiverThresholdCells > 0"))
+    int32 RiverCarveRadius = 2;
+
+    // Rise of the banks per unit of distance from the channel
+    UPROPERTY(EditAnywhere, Category = "Terrain|Rivers", meta = (ClampMin = "0.0", EditCondition = "RiverThresholdCells > 0"))
+    float RiverBankSlope = 0.5f;
+
+    // Heightmap cells between exported spline points
+    UPROPERTY(EditAnywhere, Category = "Terrain|Rivers", meta = (ClampMin = "1", EditCondition = "RiverThresholdCells > 0"))
+    int32 RiverPointSpacing = 4;
+
+    // Carving fades out over this many cells so tile borders keep the shared
+    // raw heights; the outer two rings stay raw regardless, as for erosion
+    UPROPERTY(EditAnywhere, Category = "Terrain|Rivers", meta = (ClampMin = "1", EditCondition = "RiverThresholdCells > 0"))
+    int32 RiverBorderFalloffCells = 8;
+
+    // World-space spline points of every river from the last build, ending at
+    // the sea (WaterHeight01), the tile edge or a larger river
+    UPROPERTY(VisibleAnywhere, Transient, BlueprintReadOnly, Category = "Terrain|Rivers")
+    TArray<FTerrainRiver> Rivers;
+
+    // ------------ Lakes ------------
+    // Closed depressions above WaterHeight01 with at least this many heightmap
+    // samples become lakes, each filled to its spill height (0 = no lakes).
+    // Linked water planes in SubmergedOnly mode draw them.
+    UPROPERTY(EditAnywhere, Category = "Terrain|Lakes", meta = (ClampMin = "0"))
+    int32 MinLakeCells = 0;
+
+    // Normalized depth below which a depression is not worth a lake
+    UPROPERTY(EditAnywhere, Category = "Terrain|Lakes", meta = (ClampMin = "0.0", ClampMax = "1.0", EditCondition = "MinLakeCells > 0"))
+    float MinLakeDepth = 0.002f;
+
+    UPROPERTY(VisibleAnywhere, Transient, Category = "Terrain|Lakes")
+    int32 NumLakes = 0;
+
+    // ------------ LOD ------------
+    // Build several resolution levels and show one per tile, chosen by projected screen error
+    UPROPERTY(EditAnywhere, Category = "Terrain|LOD")
+    bool bEnableLOD = false;
+
+    // Level L samples every 2^L-th heightmap vertex
+    UPROPERTY(EditAnywhere, Category = "Terrain|LOD", meta = (ClampMin = "1", ClampMax = "8", EditCondition = "bEnableLOD"))
+    int32 NumLODs = 4;
+
+    // The coarsest level whose geometric error projects to at most this many pixels is shown
+    UPROPERTY(EditAnywhere, Category = "Terrain|LOD", meta = (ClampMin = "0.1", EditCondition = "bEnableLOD"))
+    float MaxScreenSpaceError = 2.0f;
+
+    // Vertical resolution (pixels) the screen-space error is measured against
+    UPROPERTY(EditAnywhere, Category = "Terrain|LOD", meta = (ClampMin = "1.0", EditCondition = "bEnableLOD"))
+    float LODReferenceScreenHeight = 1080.0f;
+
+    // Skirts hide the cracks between neighbouring tiles at different levels
+    // (or with different adaptive triangulations)
+    UPROPERTY(EditAnywhere, Category = "Terrain|LOD", meta = (ClampMin = "0.0", EditCondition = "bEnableLOD || bAdaptiveTriangulation"))
+    float SkirtDepth = 500.0f;
+
+    // Fewer, larger triangles where the terrain is smooth (RTIN). Needs a
+    // square map of 2^k+1 samples (129, 257, ...); other maps keep the grid.
+    UPROPERTY(EditAnywhere, Category = "Terrain|LOD")
+    bool bAdaptiveTriangulation = false;
+
+    // Vertical error (world units) the full-resolution level may leave;
+    // level L allows 2^L times as much
+    UPROPERTY(EditAnywhere, Category = "Terrain|LOD", meta = (ClampMin = "0.0", EditCondition = "bAdaptiveTriangulation"))
+    float AdaptiveMaxError = 10.0f;
+
+    // Only this level carries collision (TriangleMesh collision mode)
+    UPROPERTY(EditAnywhere, Category = "Terrain|LOD", meta = (ClampMin = "0", EditCondition = "bEnableLOD"))
+    int32 CollisionLOD = 0;
+
+    // Surface triangles per level (skirts excluded) from the last build
+    UPROPERTY(VisibleAnywhere, Transient, Category = "Terrain|LOD")
+    TArray<int32> LODTriangleCounts;
+
+    UPROPERTY(VisibleAnywhere, Transient, Category = "Terrain|LOD")
+    int32 CurrentLOD = 0;
+
+    // Picks the visible level for a viewer. Called from Tick when bEnableLOD is set.
+    void UpdateLOD(const FVector& ViewLocation, float FOVDegrees);
+
+    // ------------ Collision ------------
+    UPROPERTY(EditAnywhere, Category = "Terrain|Collision")
+    ETerrainCollisionMode CollisionMode = ETerrainCollisionMode::TriangleMesh;
+
+    // Heightmap samples per heightfield cell, independent of the render LODs
+    UPROPERTY(EditAnywhere, Category = "Terrain|Collision", meta = (ClampMin = "1", EditCondition = "CollisionMode == ETerrainCollisionMode::HeightField"))
+    int32 CollisionResolutionStep = 2;
+
+    // ------------ Scatter ------------
+    // Instances placed on the terrain after every build, one HISM component per layer
+    UPROPERTY(EditAnywhere, Category = "Terrain|Scatter")
+    TArray<FTerrainScatterLayer> ScatterLayers;
+
+    // Instances handed to the components per frame during play, so a large
+    // scatter spreads over a few frames instead of one long one
+    UPROPERTY(EditAnywhere, Category = "Terrain|Scatter", meta = (ClampMin = "1"))
+    int32 MaxScatterInstancesPerFrame = 2000;
+
+    // Instances per layer from the last build
+    UPROPERTY(VisibleAnywhere, Transient, Category = "Terrain|Scatter")
+    TArray<int32> ScatterInstanceCounts;
+
     // ------------ Material ------------
     // Base material asset you assign in the editor (e.g. M_ProceduralTerrain)
     UPROPERTY(EditAnywhere, Category = "Terrain|Material")
     UMaterialInterface* BaseTerrainMaterial = nullptr;
 
+    // Vertex colour A ramps from 0 (this many heightmap cells under water)
+    // through 128 at the WaterHeight01 shoreline to 255 (this far inland),
+    // for foam and wet sand in the material. 0 leaves A at 255.
+    UPROPERTY(EditAnywhere, Category = "Terrain|Material", meta = (ClampMin = "0"))
+    int32 ShorelineRangeCells = 16;
+
 private:
     // ------------ Internal helpers ------------
-    void GenerateTerrain();
-    void CreateMesh();
-    void BuildHeightMap(TArray<float>& OutHeights) const;
+    FLandmassBuildSettings MakeBuildSettings() const;
+    void CommitMeshData(const FLandmassBuildSettings& Settings, const FLandmassMeshData& Data);
     void EnsureTerrainMaterialInstance();
+    void SetVisibleLOD(int32 LOD);
+    void SetCommittedStats(uint32 NumVertices, uint32 NumTriangles, SIZE_T NumBytes);
+    void RefreshLinkedWaterPlanes();
+
+    // Prepares one component per scatter layer and queues the instances
+    void BeginScatterCommit(const TSharedPtr<const FTerrainScatterResult, ESPMode::ThreadSafe>& Scatter);
+
+    // Adds up to Budget queued instances; true once nothing is left
+    bool PumpScatterCommit(int32 Budget);
+
+    // True while a requested build or scatter has not committed yet, so the
+    // component does not match the current settings
+    bool IsBuildPending() const { return BuildVersion->GetValue() != CommittedBuildVersion; }
+
+    // Heightmap of the last committed build and the settings that sampled it,
+    // so stages after Noise can rebuild without resampling
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> CachedHeights;
+    TSharedPtr<const FLandmassBuildSettings, ESPMode::ThreadSafe> CachedHeightsSettings;
+    TSharedPtr<const FTerrainHydrologyResult, ESPMode::ThreadSafe> CachedHydrology;
+
+    // The same build's raw noise and post-erosion heightmaps, so erosion and
+    // hydrology edits resume without resampling. Shared with CachedHeights
+    // (or each other) when the later stages are off.
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> CachedNoiseHeights;
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> CachedErodedHeights;
+
+    // Published by CommitMeshData; the lock only guards swapping the pointer
+    TSharedPtr<const FTerrainHeightQuery, ESPMode::ThreadSafe> HeightQuery;
+    mutable FRWLock HeightQueryLock;
+
+    // This landmass's share of the STATGROUP_ProceduralTerrain counters
+    uint32 StatVertices = 0;
+    uint32 StatTriangles = 0;
+    SIZE_T StatBytes = 0;
+    bool bCountedAlive = false;
+
+    // World-space error of each built level, parallel to LODTriangleCounts
+    TArray<float> LODGeometricErrors;
+
+    // Bumped by every build request; a build only commits if it still matches
+    TSharedRef<FThreadSafeCounter, ESPMode::ThreadSafe> BuildVersion = MakeShared<FThreadSafeCounter, ESPMode::ThreadSafe>();
+
+    // BuildVersion of the last build or scatter committed
+    int32 CommittedBuildVersion = 0;
+
+    UPROPERTY(Transient)
+    TArray<UHierarchicalInstancedStaticMeshComponent*> ScatterComponents;
+
+    // Scatter result still being added, and where the next batch starts
+    TSharedPtr<const FTerrainScatterResult, ESPMode::ThreadSafe> PendingScatter;
+    int32 PendingScatterLayer = 0;
+    int32 PendingScatterIndex = 0;
 
     // Our dynamic material instance (never exposed to BP)
     UPROPERTY(Transient)
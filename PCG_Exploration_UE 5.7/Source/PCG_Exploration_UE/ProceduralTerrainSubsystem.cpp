@@ -0,0 +1,175 @@
+// ProceduralTerrainSubsystem.cpp
+
+#include "ProceduralTerrainSubsystem.h"
+#include "ProceduralLandmass.h"
+#include "ProceduralWaterPlane.h"
+
+FIntPoint UProceduralTerrainSubsystem::ToCell(const FVector2D& Location)
+{
+    return FIntPoint(
+        FMath::FloorToInt32(Location.X / IndexCellSize),
+        FMath::FloorToInt32(Location.Y / IndexCellSize));
+}
+
+void UProceduralTerrainSubsystem::RegisterLandmass(AProceduralLandmass* Landmass)
+{
+    if (!Landmass)
+    {
+        return;
+    }
+
+    FLandmassEntry& Entry = Landmasses.FindOrAdd(Landmass);
+
+    const FBox2D Bounds = Landmass->GetWorldBounds2D();
+    const FIntRect Cells(ToCell(Bounds.Min), ToCell(Bounds.Max));
+
+    if (Entry.bIndexed)
+    {
+        Entry.Bounds = Bounds;
+        if (Entry.Cells == Cells)
+        {
+            return;
+        }
+        RemoveFromCells(Landmass, Entry.Cells);
+    }
+    else
+    {
+        ++NumIndexed;
+    }
+
+    for (int32 y = Cells.Min.Y; y <= Cells.Max.Y; ++y)
+    {
+        for (int32 x = Cells.Min.X; x <= Cells.Max.X; ++x)
+        {
+            CellIndex.FindOrAdd(FIntPoint(x, y)).Add(Landmass);
+        }
+    }
+
+    Entry.Cells = Cells;
+    Entry.Bounds = Bounds;
+    Entry.bIndexed = true;
+}
+
+void UProceduralTerrainSubsystem::UnregisterLandmass(AProceduralLandmass* Landmass)
+{
+    FLandmassEntry* Entry = Landmasses.Find(Landmass);
+    if (!Entry || !Entry->bIndexed)
+    {
+        return;
+    }
+
+    RemoveFromCells(Landmass, Entry->Cells);
+    --NumIndexed;
+
+    if (Entry->WaterPlanes.Num() == 0)
+    {
+        Landmasses.Remove(Landmass);
+    }
+    else
+    {
+        Entry->bIndexed = false;
+    }
+}
+
+void UProceduralTerrainSubsystem::RemoveFromCells(const TWeakObjectPtr<AProceduralLandmass>& Landmass, const FIntRect& Cells)
+{
+    for (int32 y = Cells.Min.Y; y <= Cells.Max.Y; ++y)
+    {
+        for (int32 x = Cells.Min.X; x <= Cells.Max.X; ++x)
+        {
+            const FIntPoint Cell(x, y);
+            if (TArray<TWeakObjectPtr<AProceduralLandmass>, TInlineAllocator<1>>* Occupants = CellIndex.Find(Cell))
+            {
+                Occupants->RemoveSingleSwap(Landmass);
+                if (Occupants->Num() == 0)
+                {
+                    CellIndex.Remove(Cell);
+                }
+            }
+        }
+    }
+}
+
+void UProceduralTerrainSubsystem::SetWaterPlaneLink(AProceduralWaterPlane* WaterPlane, AProceduralLandmass* Landmass)
+{
+    if (!WaterPlane)
+    {
+        return;
+    }
+
+    const TObjectKey<AProceduralLandmass>* Previous = WaterLinks.Find(WaterPlane);
+    if (Previous && *Previous == TObjectKey<AProceduralLandmass>(Landmass))
+    {
+        return;
+    }
+
+    if (Previous)
+    {
+        if (FLandmassEntry* OldEntry = Landmasses.Find(*Previous))
+        {
+            OldEntry->WaterPlanes.RemoveSingleSwap(WaterPlane);
+
+            // Planes destroyed without unlinking go too
+            OldEntry->WaterPlanes.RemoveAllSwap([](const TWeakObjectPtr<AProceduralWaterPlane>& Plane) { return !Plane.IsValid(); });
+            if (!OldEntry->bIndexed && OldEntry->WaterPlanes.Num() == 0)
+            {
+                Landmasses.Remove(*Previous);
+            }
+        }
+        WaterLinks.Remove(WaterPlane);
+    }
+
+    if (Landmass)
+    {
+        Landmasses.FindOrAdd(Landmass).WaterPlanes.Add(WaterPlane);
+        WaterLinks.Add(WaterPlane, Landmass);
+    }
+}
+
+TArray<AProceduralWaterPlane*, TInlineAllocator<4>> UProceduralTerrainSubsystem::GetLinkedWaterPlanes(const AProceduralLandmass* Landmass) const
+{
+    TArray<AProceduralWaterPlane*, TInlineAllocator<4>> WaterPlanes;
+    if (const FLandmassEntry* Entry = Landmasses.Find(Landmass))
+    {
+        for (const TWeakObjectPtr<AProceduralWaterPlane>& WaterPlane : Entry->WaterPlanes)
+        {
+            if (AProceduralWaterPlane* Live = WaterPlane.Get())
+            {
+                WaterPlanes.Add(Live);
+            }
+        }
+    }
+    return WaterPlanes;
+}
+
+AProceduralLandmass* UProceduralTerrainSubsystem::FindLandmassAt(const FVector& WorldLocation) const
+{
+    const FVector2D Location(WorldLocation.X, WorldLocation.Y);
+
+    const TArray<TWeakObjectPtr<AProceduralLandmass>, TInlineAllocator<1>>* Occupants = CellIndex.Find(ToCell(Location));
+    if (!Occupants)
+    {
+        return nullptr;
+    }
+
+    for (const TWeakObjectPtr<AProceduralLandmass>& Occupant : *Occupants)
+    {
+        AProceduralLandmass* Landmass = Occupant.Get();
+        if (!Landmass)
+        {
+            continue;
+        }
+
+        // Inclusive, so points on a shared tile edge still resolve. The box
+        // is only exact for unrotated tiles; the grid test settles the rest.
+        const FBox2D& Bounds = Landmasses.FindChecked(Landmass).Bounds;
+        if (Location.X >= Bounds.Min.X && Location.X <= Bounds.Max.X &&
+            Location.Y >= Bounds.Min.Y && Location.Y <= Bounds.Max.Y &&
+            Landmass->IsOverGrid(Location))
+        {
+            return Landmass;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,74 @@
+// ProceduralTerrainSubsystem.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ProceduralTerrainSubsystem.generated.h"
+
+class AProceduralLandmass;
+class AProceduralWaterPlane;
+
+// Registry of the landmasses and water planes in a world, so nothing has to
+// scan every actor to find them:
+//  - landmass -> linked water planes, for water sync on terrain edits
+//  - a uniform grid over landmass XY bounds, for "which tile is under this point"
+//
+// Actors register themselves while their components are registered, so the
+// registry covers editor worlds as well as play. Actors are held by key or
+// weak pointer, so an entry that outlives its actor (GC, a missed
+// unregistration) never resolves to a dangling or reused address.
+UCLASS()
+class PCG_EXPLORATION_UE_API UProceduralTerrainSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Side length of a spatial index cell, in world units
+    static constexpr double IndexCellSize = 16384.0;
+
+    // Adds the landmass to the spatial index, or re-indexes it after it moved or resized
+    void RegisterLandmass(AProceduralLandmass* Landmass);
+
+    // Drops the landmass from the spatial index; water links to it are kept
+    void UnregisterLandmass(AProceduralLandmass* Landmass);
+
+    // Links a water plane to a landmass (or unlinks it, with nullptr), replacing any previous link
+    void SetWaterPlaneLink(AProceduralWaterPlane* WaterPlane, AProceduralLandmass* Landmass);
+    void UnregisterWaterPlane(AProceduralWaterPlane* WaterPlane) { SetWaterPlaneLink(WaterPlane, nullptr); }
+
+    // Live water planes whose LinkedLandmass is Landmass
+    TArray<AProceduralWaterPlane*, TInlineAllocator<4>> GetLinkedWaterPlanes(const AProceduralLandmass* Landmass) const;
+
+    // Indexed landmass whose XY extent contains the location, or nullptr
+    UFUNCTION(BlueprintCallable, Category = "Terrain")
+    AProceduralLandmass* FindLandmassAt(const FVector& WorldLocation) const;
+
+    int32 GetNumIndexedLandmasses() const { return NumIndexed; }
+
+private:
+    struct FLandmassEntry
+    {
+        // Index cells covered by the landmass; only meaningful while bIndexed
+        FIntRect Cells;
+        FBox2D Bounds = FBox2D(ForceInit);
+        bool bIndexed = false;
+
+        TArray<TWeakObjectPtr<AProceduralWaterPlane>> WaterPlanes;
+    };
+
+    static FIntPoint ToCell(const FVector2D& Location);
+
+    void RemoveFromCells(const TWeakObjectPtr<AProceduralLandmass>& Landmass, const FIntRect& Cells);
+
+    // Entries can exist before their landmass registers (a water plane linked to
+    // it loaded first) and outlive its unregistration while water still links to it
+    TMap<TObjectKey<AProceduralLandmass>, FLandmassEntry> Landmasses;
+    TMap<TObjectKey<AProceduralWaterPlane>, TObjectKey<AProceduralLandmass>> WaterLinks;
+
+    // Inclusive cell rects, so a landmass appears in every cell it touches
+    TMap<FIntPoint, TArray<TWeakObjectPtr<AProceduralLandmass>, TInlineAllocator<1>>> CellIndex;
+
+    int32 NumIndexed = 0;
+};
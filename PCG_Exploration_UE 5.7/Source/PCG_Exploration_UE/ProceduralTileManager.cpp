@@ -0,0 +1,239 @@
+// ProceduralTileManager.cpp
+
+#include "ProceduralTileManager.h"
+#include "ProceduralLandmass.h"
+#include "ProceduralTerrainSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+
+AProceduralTileManager::AProceduralTileManager()
+{
+    PrimaryActorTick.bCanEverTick = true;
+
+    TileClass = AProceduralLandmass::StaticClass();
+}
+
+void AProceduralTileManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    for (const TPair<FIntPoint, AProceduralLandmass*>& Pair : LoadedTiles)
+    {
+        if (IsValid(Pair.Value))
+        {
+            Pair.Value->Destroy();
+        }
+    }
+    LoadedTiles.Reset();
+
+    for (AProceduralLandmass* Tile : PooledTiles)
+    {
+        if (IsValid(Tile))
+        {
+            Tile->Destroy();
+        }
+    }
+    PooledTiles.Reset();
+
+    Super::EndPlay(EndPlayReason);
+}
+
+float AProceduralTileManager::GetTileWorldSize() const
+{
+    const AProceduralLandmass* Defaults = TileClass ? TileClass->GetDefaultObject<AProceduralLandmass>() : nullptr;
+    if (!Defaults)
+    {
+        return 0.0f;
+    }
+
+    // Neighbouring tiles share their border row/column of vertices
+    return (Defaults->MapWidth - 1) * Defaults->GridSize;
+}
+
+FIntPoint AProceduralTileManager::WorldToTile(const FVector& WorldLocation) const
+{
+    const float TileSize = GetTileWorldSize();
+    if (TileSize <= KINDA_SMALL_NUMBER)
+    {
+        return FIntPoint::ZeroValue;
+    }
+
+    return FIntPoint(
+        FMath::FloorToInt(WorldLocation.X / TileSize),
+        FMath::FloorToInt(WorldLocation.Y / TileSize)
+    );
+}
+
+AProceduralLandmass* AProceduralTileManager::FindTile(const FIntPoint& TileCoord) const
+{
+    AProceduralLandmass* const* Found = LoadedTiles.Find(TileCoord);
+    return Found ? *Found : nullptr;
+}
+
+bool AProceduralTileManager::GetViewLocation(FVector& OutLocation) const
+{
+    const UWorld* World = GetWorld();
+    const APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr;
+
+    if (PC && PC->PlayerCameraManager)
+    {
+        OutLocation = PC->PlayerCameraManager->GetCameraLocation();
+        return true;
+    }
+
+    if (PC && PC->GetPawn())
+    {
+        OutLocation = PC->GetPawn()->GetActorLocation();
+        return true;
+    }
+
+    return false;
+}
+
+void AProceduralTileManager::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    const float TileSize = GetTileWorldSize();
+    FVector ViewLocation;
+    if (TileSize <= KINDA_SMALL_NUMBER || !GetViewLocation(ViewLocation))
+    {
+        return;
+    }
+
+    const FIntPoint CenterTile = WorldToTile(ViewLocation);
+
+    // Distances are measured between tile coordinates, in tiles
+    const int32 LoadRadiusSq = ViewRadiusTiles * ViewRadiusTiles;
+    const int32 UnloadRadius = ViewRadiusTiles + UnloadHysteresisTiles;
+    const int32 UnloadRadiusSq = UnloadRadius * UnloadRadius;
+
+    // --- Retire tiles that fell outside the unload ring ---
+    for (auto It = LoadedTiles.CreateIterator(); It; ++It)
+    {
+        const FIntPoint Delta = It.Key() - CenterTile;
+        if (Delta.X * Delta.X + Delta.Y * Delta.Y > UnloadRadiusSq || !IsValid(It.Value()))
+        {
+            RetireTile(It.Value());
+            It.RemoveCurrent();
+        }
+    }
+
+    // --- Collect missing tiles inside the load ring, nearest first ---
+    TArray<FIntPoint> Missing;
+    for (int32 Dy = -ViewRadiusTiles; Dy <= ViewRadiusTiles; ++Dy)
+    {
+        for (int32 Dx = -ViewRadiusTiles; Dx <= ViewRadiusTiles; ++Dx)
+        {
+            if (Dx * Dx + Dy * Dy > LoadRadiusSq)
+            {
+                continue;
+            }
+
+            const FIntPoint Coord = CenterTile + FIntPoint(Dx, Dy);
+            if (!LoadedTiles.Contains(Coord))
+            {
+                Missing.Add(Coord);
+            }
+        }
+    }
+
+    Missing.Sort([CenterTile](const FIntPoint& A, const FIntPoint& B)
+    {
+        return (A - CenterTile).SizeSquared() < (B - CenterTile).SizeSquared();
+    });
+
+    // --- Spawn / regenerate up to the per-frame budget ---
+    const int32 NumToBuild = FMath::Min(Missing.Num(), MaxTileBuildsPerFrame);
+    for (int32 i = 0; i < NumToBuild; ++i)
+    {
+        if (AProceduralLandmass* Tile = AcquireTile(Missing[i]))
+        {
+            LoadedTiles.Add(Missing[i], Tile);
+            Tile->GenerateTerrain();
+        }
+    }
+}
+
+AProceduralLandmass* AProceduralTileManager::AcquireTile(const FIntPoint& TileCoord)
+{
+    UWorld* World = GetWorld();
+    if (!World || !TileClass)
+    {
+        return nullptr;
+    }
+
+    const float TileSize = GetTileWorldSize();
+    const FVector Location(TileCoord.X * TileSize, TileCoord.Y * TileSize, GetActorLocation().Z);
+
+    AProceduralLandmass* Tile = nullptr;
+    while (!Tile && PooledTiles.Num() > 0)
+    {
+        Tile = PooledTiles.Pop(EAllowShrinking::No);
+        if (!IsValid(Tile))
+        {
+            Tile = nullptr;
+        }
+    }
+
+    if (Tile)
+    {
+        // Stays hidden until the rebuild at the new location commits (see HandleTileBuilt)
+        Tile->SetActorLocation(Location);
+    }
+    else
+    {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.Owner = this;
+        SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+        Tile = World->SpawnActor<AProceduralLandmass>(TileClass, Location, FRotator::ZeroRotator, SpawnParams);
+        if (!Tile)
+        {
+            return nullptr;
+        }
+
+        Tile->OnTerrainBuilt.AddDynamic(this, &AProceduralTileManager::HandleTileBuilt);
+    }
+
+    Tile->TileOffset = FVector2D(TileCoord.X, TileCoord.Y);
+    return Tile;
+}
+
+void AProceduralTileManager::RetireTile(AProceduralLandmass* Tile)
+{
+    if (!IsValid(Tile))
+    {
+        return;
+    }
+
+    Tile->CancelPendingBuild();
+
+    if (PooledTiles.Num() < MaxPooledTiles)
+    {
+        // Pooled tiles keep their components, so drop them from the point lookup by hand;
+        // the next committed build re-indexes them at their new location
+        if (UProceduralTerrainSubsystem* TerrainSubsystem = UWorld::GetSubsystem<UProceduralTerrainSubsystem>(GetWorld()))
+        {
+            TerrainSubsystem->UnregisterLandmass(Tile);
+        }
+
+        Tile->SetActorHiddenInGame(true);
+        Tile->SetActorEnableCollision(false);
+        PooledTiles.Add(Tile);
+    }
+    else
+    {
+        Tile->Destroy();
+    }
+}
+
+void AProceduralTileManager::HandleTileBuilt(AProceduralLandmass* Tile)
+{
+    // A pooled tile may still finish a build it started before retirement
+    if (IsValid(Tile) && !PooledTiles.Contains(Tile))
+    {
+        Tile->SetActorHiddenInGame(false);
+        Tile->SetActorEnableCollision(true);
+    }
+}
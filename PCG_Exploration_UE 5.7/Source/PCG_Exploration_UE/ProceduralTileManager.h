@@ -0,0 +1,72 @@
+// ProceduralTileManager.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ProceduralTileManager.generated.h"
+
+class AProceduralLandmass;
+
+// Streams AProceduralLandmass tiles in rings around the player camera.
+// Tiles share the world-aligned noise of BuildHeightMap, so neighbours line
+// up without any stitching; each tile sits at TileCoord * TileWorldSize.
+UCLASS()
+class PCG_EXPLORATION_UE_API AProceduralTileManager : public AActor
+{
+    GENERATED_BODY()
+
+public:
+    AProceduralTileManager();
+
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    virtual void Tick(float DeltaSeconds) override;
+
+    // ------------ Tiles ------------
+    // Landmass class spawned for every tile; make a Blueprint subclass to set noise/material defaults
+    UPROPERTY(EditAnywhere, Category = "Streaming")
+    TSubclassOf<AProceduralLandmass> TileClass;
+
+    // Tiles whose centre is within this many tiles of the camera tile are loaded
+    UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "0"))
+    int32 ViewRadiusTiles = 4;
+
+    // Extra distance (in tiles) beyond ViewRadiusTiles before a tile is retired,
+    // so walking along a tile border doesn't thrash load/unload
+    UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "0"))
+    int32 UnloadHysteresisTiles = 1;
+
+    // Upper bound on tile (re)builds started per frame
+    UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "1"))
+    int32 MaxTileBuildsPerFrame = 2;
+
+    // Retired tiles kept hidden for reuse instead of being destroyed
+    UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "0"))
+    int32 MaxPooledTiles = 16;
+
+    // ------------ Runtime helpers ------------
+    // World size of one tile edge, from the TileClass defaults
+    float GetTileWorldSize() const;
+
+    FIntPoint WorldToTile(const FVector& WorldLocation) const;
+
+    // Loaded tile at a tile coordinate, or nullptr
+    AProceduralLandmass* FindTile(const FIntPoint& TileCoord) const;
+
+    int32 GetNumLoadedTiles() const { return LoadedTiles.Num(); }
+
+protected:
+    bool GetViewLocation(FVector& OutLocation) const;
+
+    void RetireTile(AProceduralLandmass* Tile);
+    AProceduralLandmass* AcquireTile(const FIntPoint& TileCoord);
+
+    UFUNCTION()
+    void HandleTileBuilt(AProceduralLandmass* Tile);
+
+    UPROPERTY(Transient)
+    TMap<FIntPoint, AProceduralLandmass*> LoadedTiles;
+
+    UPROPERTY(Transient)
+    TArray<AProceduralLandmass*> PooledTiles;
+};
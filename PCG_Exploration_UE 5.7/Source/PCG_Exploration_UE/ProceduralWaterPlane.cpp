@@ -2,11 +2,181 @@
 
 #include "ProceduralWaterPlane.h"
 #include "ProceduralLandmass.h"
+#include "ProceduralTerrainSubsystem.h"
+#include "ProceduralWaterSubsystem.h"
+#include "TerrainHydrology.h"
+#include "TerrainStats.h"
 
 #include "ProceduralMeshComponent.h"
 #include "Materials/MaterialInterface.h"
 #include "Materials/MaterialInstanceDynamic.h"
 
+namespace
+{
+    // Sea cells and lakes are separate sections so each keeps its own bounds
+    constexpr int32 SeaSection = 0;
+    constexpr int32 LakeSection = 1;
+
+    // One axis of a box dilation over a cell mask: a cell becomes wet when any
+    // cell within Radius along the axis is wet. A running count keeps it O(Num).
+    void DilateLine(uint8* Cells, int32 Num, int32 Stride, int32 Radius, TArray<uint8>& Scratch)
+    {
+        Scratch.SetNumUninitialized(Num, EAllowShrinking::No);
+        for (int32 i = 0; i < Num; ++i)
+        {
+            Scratch[i] = Cells[i * Stride];
+        }
+
+        int32 Count = 0;
+        for (int32 i = 0; i < FMath::Min(Radius, Num); ++i)
+        {
+            Count += Scratch[i];
+        }
+
+        for (int32 i = 0; i < Num; ++i)
+        {
+            if (i + Radius < Num)
+            {
+                Count += Scratch[i + Radius];
+            }
+
+            Cells[i * Stride] = (Count > 0) ? 1 : 0;
+
+            if (i - Radius >= 0)
+            {
+                Count -= Scratch[i - Radius];
+            }
+        }
+    }
+
+    // Box dilation of a whole mask, rows then columns
+    void DilateMask(uint8* Cells, int32 NumCellsX, int32 NumCellsY, int32 Radius)
+    {
+        if (Radius <= 0)
+        {
+            return;
+        }
+
+        TArray<uint8> Scratch;
+        for (int32 y = 0; y < NumCellsY; ++y)
+        {
+            DilateLine(Cells + y * NumCellsX, NumCellsX, 1, Radius, Scratch);
+        }
+        for (int32 x = 0; x < NumCellsX; ++x)
+        {
+            DilateLine(Cells + x, NumCellsY, NumCellsX, Radius, Scratch);
+        }
+    }
+
+    // Greedy rectangle cover: grow each run right, then down while the whole
+    // span stays wet, and call Emit(x, y, SpanX, SpanY) for it. Covered cells
+    // are cleared so every cell is emitted once. Quads meet with T-junctions,
+    // which is fine for a flat surface.
+    template <typename FEmit>
+    void CoverWetCells(uint8* Wet, int32 NumCellsX, int32 NumCellsY, const FEmit& Emit)
+    {
+        for (int32 y = 0; y < NumCellsY; ++y)
+        {
+            for (int32 x = 0; x < NumCellsX; )
+            {
+                uint8* Row = Wet + y * NumCellsX;
+                if (!Row[x])
+                {
+                    ++x;
+                    continue;
+                }
+
+                int32 SpanX = 1;
+                while (x + SpanX < NumCellsX && Row[x + SpanX])
+                {
+                    ++SpanX;
+                }
+
+                int32 SpanY = 1;
+                for (; y + SpanY < NumCellsY; ++SpanY)
+                {
+                    const uint8* Next = Row + SpanY * NumCellsX;
+                    int32 i = 0;
+                    while (i < SpanX && Next[x + i])
+                    {
+                        ++i;
+                    }
+                    if (i < SpanX)
+                    {
+                        break;
+                    }
+                }
+
+                for (int32 j = 0; j < SpanY; ++j)
+                {
+                    FMemory::Memzero(Row + j * NumCellsX + x, SpanX);
+                }
+
+                Emit(x, y, SpanX, SpanY);
+                x += SpanX;
+            }
+        }
+    }
+
+    // Vertex streams of one section of flat, upward-facing quads
+    struct FWaterQuadBuffers
+    {
+        TArray<FVector>        Vertices;
+        TArray<int32>          Triangles;
+        TArray<FVector>        Normals;
+        TArray<FVector2D>      UVs;
+        TArray<FLinearColor>   Colors;
+        TArray<FProcMeshTangent> Tangents;
+
+        void AddQuad(float X0, float Y0, float X1, float Y1, float Z, const FVector2D& UV0, const FVector2D& UV1)
+        {
+            const int32 Base = Vertices.Num();
+
+            Vertices.Add(FVector(X0, Y0, Z));
+            Vertices.Add(FVector(X1, Y0, Z));
+            Vertices.Add(FVector(X0, Y1, Z));
+            Vertices.Add(FVector(X1, Y1, Z));
+
+            UVs.Add(FVector2D(UV0.X, UV0.Y));
+            UVs.Add(FVector2D(UV1.X, UV0.Y));
+            UVs.Add(FVector2D(UV0.X, UV1.Y));
+            UVs.Add(FVector2D(UV1.X, UV1.Y));
+
+            for (int32 i = 0; i < 4; ++i)
+            {
+                Normals.Add(FVector::UpVector);
+                Colors.Add(FLinearColor::White);
+                Tangents.Add(FProcMeshTangent(1.0f, 0.0f, 0.0f));
+            }
+
+            // Same winding as the full plane: front face points up (+Z)
+            Triangles.Add(Base + 0);
+            Triangles.Add(Base + 2);
+            Triangles.Add(Base + 1);
+
+            Triangles.Add(Base + 2);
+            Triangles.Add(Base + 3);
+            Triangles.Add(Base + 1);
+        }
+
+        int32 GetNumQuads() const { return Vertices.Num() / 4; }
+
+        void CreateSection(UProceduralMeshComponent* Mesh, int32 Section) const
+        {
+            Mesh->CreateMeshSection_LinearColor(
+                Section,
+                Vertices,
+                Triangles,
+                Normals,
+                UVs,
+                Colors,
+                Tangents,
+                false   // no collision for water
+            );
+        }
+    };
+}
+
 AProceduralWaterPlane::AProceduralWaterPlane()
 {
     PrimaryActorTick.bCanEverTick = true;
@@ -22,11 +192,57 @@ void AProceduralWaterPlane::OnConstruction(const FTransform& Transform)
     RefreshFromLandmass();
 }
 
+void AProceduralWaterPlane::PostRegisterAllComponents()
+{
+    Super::PostRegisterAllComponents();
+
+    if (UProceduralTerrainSubsystem* TerrainSubsystem = UWorld::GetSubsystem<UProceduralTerrainSubsystem>(GetWorld()))
+    {
+        TerrainSubsystem->SetWaterPlaneLink(this, LinkedLandmass);
+    }
+}
+
+void AProceduralWaterPlane::PostUnregisterAllComponents()
+{
+    if (UProceduralTerrainSubsystem* TerrainSubsystem = UWorld::GetSubsystem<UProceduralTerrainSubsystem>(GetWorld()))
+    {
+        TerrainSubsystem->UnregisterWaterPlane(this);
+    }
+
+    Super::PostUnregisterAllComponents();
+}
+
 void AProceduralWaterPlane::BeginPlay()
 {
     Super::BeginPlay();
 
     EnsureMaterialInstance();
+
+    if (UsesSharedWaveParameters())
+    {
+        if (UProceduralWaterSubsystem* WaterSubsystem = GetWorld()->GetSubsystem<UProceduralWaterSubsystem>())
+        {
+            WaterSubsystem->RegisterWaterPlane(WaveParameterCollection);
+            RegisteredCollection = WaveParameterCollection;
+
+            // The subsystem animates us from here on
+            SetActorTickEnabled(false);
+        }
+    }
+}
+
+void AProceduralWaterPlane::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (RegisteredCollection)
+    {
+        if (UProceduralWaterSubsystem* WaterSubsystem = GetWorld()->GetSubsystem<UProceduralWaterSubsystem>())
+        {
+            WaterSubsystem->UnregisterWaterPlane(RegisteredCollection);
+        }
+        RegisteredCollection = nullptr;
+    }
+
+    Super::EndPlay(EndPlayReason);
 }
 
 void AProceduralWaterPlane::Tick(float DeltaSeconds)
@@ -37,6 +253,8 @@ void AProceduralWaterPlane::Tick(float DeltaSeconds)
 
     if (WaterMID)
     {
+        TERRAIN_STAGE_SCOPE(Water);
+
         WaterMID->SetScalarParameterValue(TEXT("WaveTime"), InternalTime);
         WaterMID->SetScalarParameterValue(TEXT("WaveSpeed1"), WaveSpeed1);
         WaterMID->SetScalarParameterValue(TEXT("WaveSpeed2"), WaveSpeed2);
@@ -45,6 +263,14 @@ void AProceduralWaterPlane::Tick(float DeltaSeconds)
 
 void AProceduralWaterPlane::RefreshFromLandmass()
 {
+    TERRAIN_STAGE_SCOPE(Water);
+
+    // LinkedLandmass is editable and Blueprint-writable, so keep the registry in step (no-op if unchanged)
+    if (UProceduralTerrainSubsystem* TerrainSubsystem = UWorld::GetSubsystem<UProceduralTerrainSubsystem>(GetWorld()))
+    {
+        TerrainSubsystem->SetWaterPlaneLink(this, LinkedLandmass);
+    }
+
     // If we have a landmass linked, auto-sync size and height
     if (LinkedLandmass)
     {
@@ -74,15 +300,36 @@ void AProceduralWaterPlane::EnsureMaterialInstance()
         return;
     }
 
+    if (UsesSharedWaveParameters())
+    {
+        // No per-actor material: one material for all planes, variation in primitive data
+        WaterMID = nullptr;
+        if (WaterMaterial)
+        {
+            Mesh->SetMaterial(SeaSection, WaterMaterial);
+            Mesh->SetMaterial(LakeSection, WaterMaterial);
+        }
+
+        Mesh->SetCustomPrimitiveDataFloat(0, WaveSpeedScale);
+        Mesh->SetCustomPrimitiveDataFloat(1, WavePhaseOffset);
+        return;
+    }
+
     if (!WaterMID)
     {
-        UMaterialInterface* BaseMat = WaterMaterial ? WaterMaterial : Mesh->GetMaterial(0);
+        UMaterialInterface* BaseMat = WaterMaterial ? WaterMaterial : Mesh->GetMaterial(SeaSection);
         if (BaseMat)
         {
             WaterMID = UMaterialInstanceDynamic::Create(BaseMat, this);
-            Mesh->SetMaterial(0, WaterMID);
+            Mesh->SetMaterial(SeaSection, WaterMID);
         }
     }
+
+    // Lakes share the sea's material
+    if (WaterMID)
+    {
+        Mesh->SetMaterial(LakeSection, WaterMID);
+    }
 }
 
 void AProceduralWaterPlane::BuildWaterPlane()
@@ -92,6 +339,26 @@ void AProceduralWaterPlane::BuildWaterPlane()
         return;
     }
 
+    if (MeshMode == EWaterMeshMode::SubmergedOnly && LinkedLandmass)
+    {
+        // The heightmap can lag the landmass settings while a build is in flight;
+        // the landmass refreshes us again once the new one is committed
+        const TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> Heights = LinkedLandmass->GetCachedHeightMap();
+        const int32 NumVertsX = LinkedLandmass->MapWidth;
+        const int32 NumVertsY = LinkedLandmass->MapHeight;
+
+        if (Heights.IsValid() && NumVertsX >= 2 && NumVertsY >= 2 && Heights->Num() == NumVertsX * NumVertsY)
+        {
+            const TSharedPtr<const FTerrainHydrologyResult, ESPMode::ThreadSafe> Hydrology = LinkedLandmass->GetHydrology();
+            BuildSubmergedWaterMesh(*Heights, NumVertsX, NumVertsY, LinkedLandmass->GetDefaultWaterHeight01(), Hydrology.Get());
+            return;
+        }
+    }
+
+    NumWaterQuads = 1;
+    NumLakeQuads = 0;
+    Mesh->ClearMeshSection(LakeSection);
+
     TArray<FVector>        Vertices;
     TArray<int32>          Triangles;
     TArray<FVector>        Normals;
@@ -139,10 +406,10 @@ void AProceduralWaterPlane::BuildWaterPlane()
     Triangles.Add(1);
 
     // Optional: clear old section before recreating
-    Mesh->ClearMeshSection(0);
+    Mesh->ClearMeshSection(SeaSection);
 
     Mesh->CreateMeshSection_LinearColor(
-        0,
+        SeaSection,
         Vertices,
         Triangles,
         Normals,
@@ -151,4 +418,134 @@ void AProceduralWaterPlane::BuildWaterPlane()
         Tangents,
         false   // no collision for water
     );
-}
\ No newline at end of file
+}
+
+void AProceduralWaterPlane::BuildSubmergedWaterMesh(const TArray<float>& Heights, int32 NumVertsX, int32 NumVertsY, float WaterLevel01, const FTerrainHydrologyResult* Hydrology)
+{
+    const int32 NumCellsX = NumVertsX - 1;
+    const int32 NumCellsY = NumVertsY - 1;
+
+    // Dry tiles cost nothing
+    Mesh->ClearMeshSection(SeaSection);
+    Mesh->ClearMeshSection(LakeSection);
+    NumWaterQuads = 0;
+    NumLakeQuads = 0;
+
+    // Same local frame and UV layout as the full plane, so the material sees no difference
+    const float HX = PlaneSizeX * 0.5f;
+    const float HY = PlaneSizeY * 0.5f;
+    const float CellX = PlaneSizeX / NumCellsX;
+    const float CellY = PlaneSizeY / NumCellsY;
+
+    // Local Z is relative to the actor, which sits at sea level
+    auto AddCellRect = [&](FWaterQuadBuffers& Buffers, int32 x, int32 y, int32 SpanX, int32 SpanY, float Z)
+    {
+        Buffers.AddQuad(
+            x * CellX - HX, y * CellY - HY,
+            (x + SpanX) * CellX - HX, (y + SpanY) * CellY - HY,
+            Z,
+            FVector2D(static_cast<float>(x) / NumCellsX, static_cast<float>(y) / NumCellsY),
+            FVector2D(static_cast<float>(x + SpanX) / NumCellsX, static_cast<float>(y + SpanY) / NumCellsY));
+    };
+
+    const int32 Margin = FMath::Max(ShorelineMargin, 0);
+
+    // --- Sea: cells with any corner at or below the water level ---
+    TArray<uint8> Wet;
+    Wet.SetNumUninitialized(NumCellsX * NumCellsY);
+
+    int32 NumWetCells = 0;
+    for (int32 y = 0; y < NumCellsY; ++y)
+    {
+        const float* Row0 = Heights.GetData() + y * NumVertsX;
+        const float* Row1 = Row0 + NumVertsX;
+
+        for (int32 x = 0; x < NumCellsX; ++x)
+        {
+            const float Lowest = FMath::Min(FMath::Min(Row0[x], Row0[x + 1]), FMath::Min(Row1[x], Row1[x + 1]));
+            const uint8 bWet = (Lowest <= WaterLevel01) ? 1 : 0;
+            Wet[y * NumCellsX + x] = bWet;
+            NumWetCells += bWet;
+        }
+    }
+
+    if (NumWetCells > 0)
+    {
+        DilateMask(Wet.GetData(), NumCellsX, NumCellsY, Margin);
+
+        FWaterQuadBuffers Sea;
+        CoverWetCells(Wet.GetData(), NumCellsX, NumCellsY, [&](int32 x, int32 y, int32 SpanX, int32 SpanY)
+        {
+            AddCellRect(Sea, x, y, SpanX, SpanY, 0.0f);
+        });
+
+        NumWaterQuads = Sea.GetNumQuads();
+        Sea.CreateSection(Mesh, SeaSection);
+    }
+
+    // --- Lakes: one fitted patch per basin at its own spill height ---
+    if (!bDrawLakes || !Hydrology || Hydrology->Lakes.Num() == 0 || !LinkedLandmass)
+    {
+        return;
+    }
+
+    const float HeightMultiplier = LinkedLandmass->HeightMultiplier;
+    FWaterQuadBuffers Lakes;
+    TArray<uint8> Spill;
+
+    for (const FTerrainLake& Lake : Hydrology->Lakes)
+    {
+        // Cells touching a submerged sample, grown by the margin, clamped to the map
+        const int32 MinX = FMath::Max(Lake.Bounds.Min.X - 1 - Margin, 0);
+        const int32 MinY = FMath::Max(Lake.Bounds.Min.Y - 1 - Margin, 0);
+        const int32 MaxX = FMath::Min(Lake.Bounds.Max.X + Margin, NumCellsX - 1);
+        const int32 MaxY = FMath::Min(Lake.Bounds.Max.Y + Margin, NumCellsY - 1);
+        const int32 RegionX = MaxX - MinX + 1;
+        const int32 RegionY = MaxY - MinY + 1;
+
+        Wet.SetNumUninitialized(RegionX * RegionY, EAllowShrinking::No);
+        Spill.SetNumUninitialized(RegionX * RegionY, EAllowShrinking::No);
+        for (int32 y = 0; y < RegionY; ++y)
+        {
+            const float* Row0 = Heights.GetData() + (MinY + y) * NumVertsX;
+            const float* Row1 = Row0 + NumVertsX;
+
+            for (int32 x = 0; x < RegionX; ++x)
+            {
+                const int32 CellXIndex = MinX + x;
+                const int32 CellYIndex = MinY + y;
+                const bool bWet =
+                    Lake.IsSubmerged(CellXIndex, CellYIndex) || Lake.IsSubmerged(CellXIndex + 1, CellYIndex) ||
+                    Lake.IsSubmerged(CellXIndex, CellYIndex + 1) || Lake.IsSubmerged(CellXIndex + 1, CellYIndex + 1);
+
+                // Dips below the lake level outside the basin lie past its
+                // spill point; water there would float above open ground
+                const float Lowest = FMath::Min(FMath::Min(Row0[CellXIndex], Row0[CellXIndex + 1]), FMath::Min(Row1[CellXIndex], Row1[CellXIndex + 1]));
+                Wet[y * RegionX + x] = bWet ? 1 : 0;
+                Spill[y * RegionX + x] = (!bWet && Lowest < Lake.Level01) ? 1 : 0;
+            }
+        }
+
+        // The margin only grows onto ground at or above the lake level, where the shore hides it
+        DilateMask(Wet.GetData(), RegionX, RegionY, Margin);
+        for (int32 i = 0; i < RegionX * RegionY; ++i)
+        {
+            if (Spill[i])
+            {
+                Wet[i] = 0;
+            }
+        }
+
+        const float Z = (Lake.Level01 - WaterLevel01) * HeightMultiplier;
+        CoverWetCells(Wet.GetData(), RegionX, RegionY, [&](int32 x, int32 y, int32 SpanX, int32 SpanY)
+        {
+            AddCellRect(Lakes, MinX + x, MinY + y, SpanX, SpanY, Z);
+        });
+    }
+
+    NumLakeQuads = Lakes.GetNumQuads();
+    if (NumLakeQuads > 0)
+    {
+        Lakes.CreateSection(Mesh, LakeSection);
+    }
+}
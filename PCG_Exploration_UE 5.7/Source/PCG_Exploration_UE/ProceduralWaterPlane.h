@@ -9,7 +9,17 @@
 class UProceduralMeshComponent;
 class UMaterialInterface;
 class UMaterialInstanceDynamic;
+class UMaterialParameterCollection;
 class AProceduralLandmass;
+struct FTerrainHydrologyResult;
+
+// What the water mesh covers
+UENUM(BlueprintType)
+enum class EWaterMeshMode : uint8
+{
+    FullPlane,      // One quad over the whole landmass extent
+    SubmergedOnly   // Only cells at or below water level (plus ShorelineMargin), merged into large quads, plus the landmass's lakes
+};
 
 UCLASS()
 class PCG_EXPLORATION_UE_API AProceduralWaterPlane : public AActor
@@ -20,10 +30,13 @@ public:
     AProceduralWaterPlane();
 
     virtual void OnConstruction(const FTransform& Transform) override;
+    virtual void PostRegisterAllComponents() override;
+    virtual void PostUnregisterAllComponents() override;
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     virtual void Tick(float DeltaSeconds) override;
 
-    // Called by the landmass when its water height changes
+    // Called by the landmass when its water height changes or it rebuilds
     UFUNCTION(BlueprintCallable, Category = "Water")
     void RefreshFromLandmass();
 
@@ -35,9 +48,17 @@ protected:
     // Rebuilds the quad mesh
     void BuildWaterPlane();
 
-    // Creates the MID if needed and assigns it to the mesh
+    // SubmergedOnly path; Heights is the linked landmass's normalized heightmap.
+    // Sea quads go to section 0, quads for Hydrology's lakes to section 1.
+    void BuildSubmergedWaterMesh(const TArray<float>& Heights, int32 NumVertsX, int32 NumVertsY, float WaterLevel01, const FTerrainHydrologyResult* Hydrology);
+
+    // Creates the MID if needed and assigns it to the mesh. In shared mode
+    // the mesh keeps WaterMaterial itself and only gets custom primitive data.
     void EnsureMaterialInstance();
 
+    // Shared mode needs a collection to write to; otherwise the plane ticks its own MID
+    bool UsesSharedWaveParameters() const { return bUseSharedWaveParameters && WaveParameterCollection != nullptr; }
+
     // ---------- Components ----------
     UPROPERTY(VisibleAnywhere, Category = "Water")
     UProceduralMeshComponent* Mesh = nullptr;
@@ -49,6 +70,26 @@ protected:
     UPROPERTY(EditAnywhere, Category = "Water|Size", meta = (ClampMin = "0.0"))
     float PlaneSizeY = 10000.0f;
 
+    // ---------- Mesh ----------
+    // Falls back to FullPlane until the linked landmass has a heightmap
+    UPROPERTY(EditAnywhere, Category = "Water|Mesh")
+    EWaterMeshMode MeshMode = EWaterMeshMode::SubmergedOnly;
+
+    // Cells of water kept around every submerged cell, so the edge stays hidden under the shore
+    UPROPERTY(EditAnywhere, Category = "Water|Mesh", meta = (ClampMin = "0", EditCondition = "MeshMode == EWaterMeshMode::SubmergedOnly"))
+    int32 ShorelineMargin = 2;
+
+    // Draw the linked landmass's lakes (see AProceduralLandmass::MinLakeCells), each at its own level
+    UPROPERTY(EditAnywhere, Category = "Water|Mesh", meta = (EditCondition = "MeshMode == EWaterMeshMode::SubmergedOnly"))
+    bool bDrawLakes = true;
+
+    // Quads emitted by the last build, for the sea and for all lakes together
+    UPROPERTY(VisibleAnywhere, Transient, Category = "Water|Mesh")
+    int32 NumWaterQuads = 0;
+
+    UPROPERTY(VisibleAnywhere, Transient, Category = "Water|Mesh")
+    int32 NumLakeQuads = 0;
+
     // ---------- Material ----------
     UPROPERTY(EditAnywhere, Category = "Water|Material")
     UMaterialInterface* WaterMaterial = nullptr;
@@ -57,11 +98,36 @@ protected:
     UMaterialInstanceDynamic* WaterMID = nullptr;
 
     // ---------- Wave motion ----------
+    // Let UProceduralWaterSubsystem animate the waves through WaveParameterCollection
+    // instead of ticking this actor. The material then reads WaveTime/WaveSpeed1/
+    // WaveSpeed2 from the collection and the per-tile values below from custom
+    // primitive data, so every plane shares WaterMaterial and batches together.
     UPROPERTY(EditAnywhere, Category = "Water|Waves")
+    bool bUseSharedWaveParameters = true;
+
+    UPROPERTY(EditAnywhere, Category = "Water|Waves", meta = (EditCondition = "bUseSharedWaveParameters"))
+    UMaterialParameterCollection* WaveParameterCollection = nullptr;
+
+    // Custom primitive data 0: multiplier on the global wave speeds
+    UPROPERTY(EditAnywhere, Category = "Water|Waves", meta = (EditCondition = "bUseSharedWaveParameters"))
+    float WaveSpeedScale = 1.0f;
+
+    // Custom primitive data 1: seconds added to the global WaveTime
+    UPROPERTY(EditAnywhere, Category = "Water|Waves", meta = (EditCondition = "bUseSharedWaveParameters"))
+    float WavePhaseOffset = 0.0f;
+
+    // Per-actor path, used when shared mode is off or has no collection. In
+    // shared mode the speeds are global (UProceduralWaterSubsystem::SetWaveSpeeds)
+    // and this tile only scales them by WaveSpeedScale.
+    UPROPERTY(EditAnywhere, Category = "Water|Waves", meta = (EditCondition = "!bUseSharedWaveParameters || WaveParameterCollection == nullptr"))
     float WaveSpeed1 = 0.15f;
 
-    UPROPERTY(EditAnywhere, Category = "Water|Waves")
+    UPROPERTY(EditAnywhere, Category = "Water|Waves", meta = (EditCondition = "!bUseSharedWaveParameters || WaveParameterCollection == nullptr"))
     float WaveSpeed2 = -0.12f;
 
     float InternalTime = 0.0f;
+
+    // Collection registered with the subsystem in BeginPlay, released in EndPlay
+    UPROPERTY(Transient)
+    UMaterialParameterCollection* RegisteredCollection = nullptr;
 };
@@ -0,0 +1,61 @@
+// ProceduralWaterSubsystem.cpp
+
+#include "ProceduralWaterSubsystem.h"
+#include "TerrainStats.h"
+
+#include "Engine/World.h"
+#include "Materials/MaterialParameterCollection.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
+
+void UProceduralWaterSubsystem::RegisterWaterPlane(UMaterialParameterCollection* Collection)
+{
+    if (Collection)
+    {
+        ++Collections.FindOrAdd(Collection);
+    }
+}
+
+void UProceduralWaterSubsystem::UnregisterWaterPlane(UMaterialParameterCollection* Collection)
+{
+    int32* Count = Collection ? Collections.Find(Collection) : nullptr;
+    if (Count && --(*Count) <= 0)
+    {
+        Collections.Remove(Collection);
+    }
+}
+
+void UProceduralWaterSubsystem::SetWaveSpeeds(float InWaveSpeed1, float InWaveSpeed2)
+{
+    WaveSpeed1 = InWaveSpeed1;
+    WaveSpeed2 = InWaveSpeed2;
+}
+
+void UProceduralWaterSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    TERRAIN_STAGE_SCOPE(Water);
+
+    WaveTime += DeltaTime;
+
+    UWorld* World = GetWorld();
+    if (!World)
+    {
+        return;
+    }
+
+    for (const TPair<UMaterialParameterCollection*, int32>& Pair : Collections)
+    {
+        if (UMaterialParameterCollectionInstance* Instance = World->GetParameterCollectionInstance(Pair.Key))
+        {
+            Instance->SetScalarParameterValue(TEXT("WaveTime"), WaveTime);
+            Instance->SetScalarParameterValue(TEXT("WaveSpeed1"), WaveSpeed1);
+            Instance->SetScalarParameterValue(TEXT("WaveSpeed2"), WaveSpeed2);
+        }
+    }
+}
+
+TStatId UProceduralWaterSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UProceduralWaterSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,48 @@
+// ProceduralWaterSubsystem.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProceduralWaterSubsystem.generated.h"
+
+class UMaterialParameterCollection;
+
+// Drives the wave animation of every water plane in the world with one
+// parameter write per frame. Planes in shared mode register their collection
+// here and stop ticking; the subsystem advances WaveTime and writes WaveTime,
+// WaveSpeed1 and WaveSpeed2 to each registered collection.
+//
+// Per-tile variation goes through custom primitive data on the water mesh
+// (see AProceduralWaterPlane), so all planes can share one material and batch.
+UCLASS()
+class PCG_EXPLORATION_UE_API UProceduralWaterSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Reference counted; a collection is written while at least one plane uses it
+    void RegisterWaterPlane(UMaterialParameterCollection* Collection);
+    void UnregisterWaterPlane(UMaterialParameterCollection* Collection);
+
+    // Global speeds every shared-mode plane scales by its own WaveSpeedScale
+    UFUNCTION(BlueprintCallable, Category = "Water")
+    void SetWaveSpeeds(float InWaveSpeed1, float InWaveSpeed2);
+
+    UFUNCTION(BlueprintPure, Category = "Water")
+    float GetWaveTime() const { return WaveTime; }
+
+    // ------------ UTickableWorldSubsystem ------------
+    virtual void Tick(float DeltaTime) override;
+    virtual bool IsTickable() const override { return Collections.Num() > 0; }
+    virtual TStatId GetStatId() const override;
+
+private:
+    // Collection -> number of planes using it
+    UPROPERTY(Transient)
+    TMap<UMaterialParameterCollection*, int32> Collections;
+
+    float WaveTime = 0.0f;
+    float WaveSpeed1 = 0.15f;
+    float WaveSpeed2 = -0.12f;
+};
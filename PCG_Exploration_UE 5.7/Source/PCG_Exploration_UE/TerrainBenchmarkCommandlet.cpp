@@ -0,0 +1,291 @@
+// TerrainBenchmarkCommandlet.cpp
+
+#include "TerrainBenchmarkCommandlet.h"
+#include "TerrainMeshBuilder.h"
+
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PCG_Exploration_UE.h"
+
+namespace
+{
+    struct FBenchmarkRow
+    {
+        FString Stage;
+        FString Variant;
+        int32   Size = 0;
+        int32   Octaves = 0;
+        int32   Bands = 0;
+        int32   Threads = 0;
+        int32   Iterations = 0;
+        double  MedianMs = 0.0;
+        double  MinMs = 0.0;
+        double  NsPerSample = 0.0;
+        double  VerticesPerSecond = 0.0;
+
+        // Bytes the stage's output holds, and the largest growth in resident
+        // memory across one run of the stage (output still alive)
+        int64   OutputBytes = 0;
+        int64   StageMemoryBytes = 0;
+    };
+
+    int64 UsedPhysicalBytes()
+    {
+        return static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical);
+    }
+
+    // Workers that can run the stage at once: the calling thread plus the
+    // task graph's pool, capped by the number of work items
+    int32 EffectiveThreads(const FLandmassBuildSettings& Settings, int32 NumItems)
+    {
+        if (!Settings.bParallel)
+        {
+            return 1;
+        }
+        return FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, FMath::Max(NumItems, 1));
+    }
+
+    TArray<int32> ParseIntList(const FString& Params, const TCHAR* Key, const TArray<int32>& Default)
+    {
+        FString Value;
+        if (!FParse::Value(*Params, Key, Value, false))
+        {
+            return Default;
+        }
+
+        TArray<FString> Parts;
+        Value.ParseIntoArray(Parts, TEXT(","));
+
+        TArray<int32> Result;
+        for (const FString& Part : Parts)
+        {
+            Result.Add(FCString::Atoi(*Part.TrimStartAndEnd()));
+        }
+        return Result.Num() > 0 ? Result : Default;
+    }
+
+    double Median(TArray<double> Samples)
+    {
+        Samples.Sort();
+        const int32 Mid = Samples.Num() / 2;
+        return (Samples.Num() % 2) ? Samples[Mid] : 0.5 * (Samples[Mid - 1] + Samples[Mid]);
+    }
+
+    // Fixed, cache-free settings so runs are comparable between builds
+    FLandmassBuildSettings MakeSettings(int32 Size, int32 Octaves, int32 Threads, bool bVectorKernel)
+    {
+        FLandmassBuildSettings Settings;
+        Settings.MapWidth = Size;
+        Settings.MapHeight = Size;
+        Settings.GridSize = 100.0f;
+        Settings.HeightMultiplier = 2000.0f;
+        Settings.bParallel = (Threads != 1);
+        Settings.RowsPerBand = (Threads > 1) ? FMath::DivideAndRoundUp(Size, Threads) : 16;
+        Settings.bUseHeightCache = false;
+        Settings.DebugName = TEXT("TerrainBenchmark");
+
+        FTerrainNoiseSampler& Sampler = Settings.Noise;
+        Sampler.MapWidth = Size;
+        Sampler.Offset = FVector2D(1234.5, -987.25);
+        Sampler.NoiseScale = 80.0f;
+        Sampler.Octaves = Octaves;
+        Sampler.Persistence = 0.5f;
+        Sampler.Lacunarity = 2.0f;
+        Sampler.bUseVectorKernel = bVectorKernel && TerrainNoise::IsVectorKernelAvailable();
+
+        return Settings;
+    }
+
+    void FinishRow(FBenchmarkRow& Row, const TArray<double>& SamplesMs, int64 NumSamples, int64 OutputBytes, int64 StageMemoryBytes)
+    {
+        Row.Iterations = SamplesMs.Num();
+        Row.MedianMs = Median(SamplesMs);
+        Row.MinMs = FMath::Min(SamplesMs);
+        Row.NsPerSample = Row.MedianMs * 1.0e6 / FMath::Max<int64>(NumSamples, 1);
+        Row.VerticesPerSecond = (Row.MedianMs > 0.0) ? NumSamples / (Row.MedianMs * 1.0e-3) : 0.0;
+        Row.OutputBytes = OutputBytes;
+        Row.StageMemoryBytes = StageMemoryBytes;
+
+        UE_LOG(LogProceduralTerrain, Display, TEXT("%-9s %-18s %5d^2 oct=%d bands=%d threads=%d  median %9.3f ms  %7.2f ns/sample  %6.1f MB (+%.1f MB resident)"),
+            *Row.Stage, *Row.Variant, Row.Size, Row.Octaves, Row.Bands, Row.Threads,
+            Row.MedianMs, Row.NsPerSample, Row.OutputBytes / (1024.0 * 1024.0), Row.StageMemoryBytes / (1024.0 * 1024.0));
+    }
+
+    FString ToCsv(const TArray<FBenchmarkRow>& Rows)
+    {
+        FString Csv = TEXT("stage,variant,size,octaves,bands,threads,iterations,median_ms,min_ms,ns_per_sample,vertices_per_second,output_bytes,stage_memory_bytes\n");
+        for (const FBenchmarkRow& Row : Rows)
+        {
+            Csv += FString::Printf(TEXT("%s,%s,%d,%d,%d,%d,%d,%.4f,%.4f,%.4f,%.0f,%lld,%lld\n"),
+                *Row.Stage, *Row.Variant, Row.Size, Row.Octaves, Row.Bands, Row.Threads, Row.Iterations,
+                Row.MedianMs, Row.MinMs, Row.NsPerSample, Row.VerticesPerSecond,
+                Row.OutputBytes, Row.StageMemoryBytes);
+        }
+        return Csv;
+    }
+
+    FString ToJson(const TArray<FBenchmarkRow>& Rows)
+    {
+        FString Json = FString::Printf(TEXT("{\n  \"build_version\": \"%s\",\n  \"cores\": %d,\n  \"results\": [\n"),
+            *FApp::GetBuildVersion(), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+
+        for (int32 i = 0; i < Rows.Num(); ++i)
+        {
+            const FBenchmarkRow& Row = Rows[i];
+            Json += FString::Printf(
+                TEXT("    { \"stage\": \"%s\", \"variant\": \"%s\", \"size\": %d, \"octaves\": %d, \"bands\": %d, \"threads\": %d, \"iterations\": %d, ")
+                TEXT("\"median_ms\": %.4f, \"min_ms\": %.4f, \"ns_per_sample\": %.4f, \"vertices_per_second\": %.0f, ")
+                TEXT("\"output_bytes\": %lld, \"stage_memory_bytes\": %lld }%s\n"),
+                *Row.Stage, *Row.Variant, Row.Size, Row.Octaves, Row.Bands, Row.Threads, Row.Iterations,
+                Row.MedianMs, Row.MinMs, Row.NsPerSample, Row.VerticesPerSecond,
+                Row.OutputBytes, Row.StageMemoryBytes,
+                (i + 1 < Rows.Num()) ? TEXT(",") : TEXT(""));
+        }
+
+        Json += TEXT("  ]\n}\n");
+        return Json;
+    }
+}
+
+UTerrainBenchmarkCommandlet::UTerrainBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UTerrainBenchmarkCommandlet::Main(const FString& Params)
+{
+    const TArray<int32> Sizes = ParseIntList(Params, TEXT("Sizes="), { 64, 128, 256, 512, 1024, 2048, 4096 });
+    const TArray<int32> OctaveCounts = ParseIntList(Params, TEXT("Octaves="), { 1, 4, 8 });
+    const TArray<int32> ThreadCounts = ParseIntList(Params, TEXT("Threads="), { 1, 4, 0 });
+
+    int32 Iterations = 5;
+    FParse::Value(*Params, TEXT("Iterations="), Iterations);
+    Iterations = FMath::Max(Iterations, 1);
+
+    int32 MaxMeshSize = 2048;
+    FParse::Value(*Params, TEXT("MaxMeshSize="), MaxMeshSize);
+
+    FString OutBase = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / (TEXT("TerrainBenchmark-") + FDateTime::Now().ToString());
+    FParse::Value(*Params, TEXT("Out="), OutBase);
+
+    TArray<FBenchmarkRow> Rows;
+    TArray<double> SamplesMs;
+
+    for (const int32 Size : Sizes)
+    {
+        if (Size < 2)
+        {
+            continue;
+        }
+
+        const int64 NumSamples = static_cast<int64>(Size) * Size;
+
+        // --- Heightmap stage: octaves x kernel x concurrency ---
+        for (const int32 Octaves : OctaveCounts)
+        {
+            for (const bool bVector : { false, true })
+            {
+                for (const int32 Threads : ThreadCounts)
+                {
+                    const FLandmassBuildSettings Settings = MakeSettings(Size, Octaves, Threads, bVector);
+
+                    TArray<float> Heights;
+                    int64 StageMemoryBytes = 0;
+                    SamplesMs.Reset();
+                    for (int32 Iter = 0; Iter < Iterations; ++Iter)
+                    {
+                        // Freed first so every run pays for its own output
+                        Heights.Empty();
+                        const int64 Baseline = UsedPhysicalBytes();
+
+                        const double Start = FPlatformTime::Seconds();
+                        TerrainMeshBuilder::BuildHeightMap(Settings, Heights);
+                        SamplesMs.Add((FPlatformTime::Seconds() - Start) * 1000.0);
+
+                        StageMemoryBytes = FMath::Max(StageMemoryBytes, UsedPhysicalBytes() - Baseline);
+                    }
+
+                    const int32 NumBands = Settings.bParallel ? FMath::DivideAndRoundUp(Size, FMath::Max(Settings.RowsPerBand, 1)) : 1;
+
+                    FBenchmarkRow& Row = Rows.AddDefaulted_GetRef();
+                    Row.Stage = TEXT("heightmap");
+                    Row.Variant = Settings.Noise.bUseVectorKernel ? TEXT("vector") : TEXT("scalar");
+                    Row.Size = Size;
+                    Row.Octaves = Octaves;
+                    Row.Bands = NumBands;
+                    Row.Threads = EffectiveThreads(Settings, NumBands);
+                    FinishRow(Row, SamplesMs, NumSamples, Heights.GetAllocatedSize(), StageMemoryBytes);
+                }
+            }
+        }
+
+        // --- Mesh stage: independent of octaves and of the band split ---
+        if (Size > MaxMeshSize)
+        {
+            continue;
+        }
+
+        const int32 MeshOctaves = OctaveCounts.Num() > 0 ? OctaveCounts[0] : 4;
+        FLandmassBuildSettings Settings = MakeSettings(Size, MeshOctaves, 0, true);
+
+        TArray<float> Heights;
+        TerrainMeshBuilder::BuildHeightMap(Settings, Heights);
+
+        for (const bool bCentralDifference : { false, true })
+        {
+            Settings.bCentralDifferenceNormals = bCentralDifference;
+
+            SIZE_T OutputBytes = 0;
+            int32 NumSections = 0;
+            int64 StageMemoryBytes = 0;
+            SamplesMs.Reset();
+            for (int32 Iter = 0; Iter < Iterations; ++Iter)
+            {
+                const int64 Baseline = UsedPhysicalBytes();
+
+                FLandmassMeshData Data;
+                const double Start = FPlatformTime::Seconds();
+                TerrainMeshBuilder::BuildMesh(Settings, Heights, Data);
+                SamplesMs.Add((FPlatformTime::Seconds() - Start) * 1000.0);
+
+                StageMemoryBytes = FMath::Max(StageMemoryBytes, UsedPhysicalBytes() - Baseline);
+
+                OutputBytes = Data.LODs[0]->GetAllocatedSize() + Data.LODs[0]->Triangles->GetAllocatedSize();
+                NumSections = Data.LODs.Num();
+            }
+
+            FBenchmarkRow& Row = Rows.AddDefaulted_GetRef();
+            Row.Stage = TEXT("mesh");
+            Row.Variant = bCentralDifference ? TEXT("central-difference") : TEXT("triangle-normals");
+            Row.Size = Size;
+            Row.Octaves = MeshOctaves;
+            // Sections are the mesh stage's unit of parallel work
+            Row.Bands = NumSections;
+            Row.Threads = EffectiveThreads(Settings, NumSections);
+            FinishRow(Row, SamplesMs, NumSamples, OutputBytes, StageMemoryBytes);
+        }
+    }
+
+    const FString CsvPath = OutBase + TEXT(".csv");
+    const FString JsonPath = OutBase + TEXT(".json");
+    const bool bWrote = FFileHelper::SaveStringToFile(ToCsv(Rows), *CsvPath)
+        && FFileHelper::SaveStringToFile(ToJson(Rows), *JsonPath);
+
+    if (!bWrote)
+    {
+        UE_LOG(LogProceduralTerrain, Error, TEXT("TerrainBenchmark: could not write results to %s.{csv,json}"), *OutBase);
+        return 1;
+    }
+
+    UE_LOG(LogProceduralTerrain, Display, TEXT("TerrainBenchmark: %d results written to %s and %s"), Rows.Num(), *CsvPath, *JsonPath);
+    return 0;
+}
@@ -0,0 +1,36 @@
+// TerrainBenchmarkCommandlet.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TerrainBenchmarkCommandlet.generated.h"
+
+// Times the landmass build stages over a sweep of map sizes, octave counts,
+// noise kernels and concurrency limits, and writes the results as CSV and
+// JSON under Saved/Benchmarks. Runs headless:
+//
+//   UnrealEditor-Cmd PCG_Exploration_UE.uproject -run=TerrainBenchmark -nullrhi
+//       [-Sizes=64,256,1024,4096] [-Octaves=1,4,8] [-Threads=1,4,0]
+//       [-Iterations=5] [-MaxMeshSize=2048] [-Out=<path without extension>]
+//
+// Threads=0 means unlimited (one band per RowsPerBand rows); N > 0 splits the
+// heightmap into N bands, so at most N workers run at once. Sizes above
+// MaxMeshSize skip the mesh stage to keep peak memory reasonable.
+//
+// "threads" is the number of workers that can actually run a stage at once
+// (the task graph's pool plus the caller, capped by the number of heightmap
+// bands or mesh sections).
+// "stage_memory_bytes" is the largest growth in resident memory from just
+// before a run to just after it, so it covers the output and anything the
+// allocator kept; scratch freed inside the stage is not visible.
+UCLASS()
+class PCG_EXPLORATION_UE_API UTerrainBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UTerrainBenchmarkCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
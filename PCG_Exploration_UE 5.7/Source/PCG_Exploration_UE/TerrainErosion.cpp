@@ -0,0 +1,449 @@
+// TerrainErosion.cpp
+
+#include "TerrainErosion.h"
+#include "TerrainHash.h"
+#include "TerrainMeshBuilder.h"
+#include "TerrainParallel.h"
+#include "TerrainStats.h"
+
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+#include "PCG_Exploration_UE.h"
+
+namespace
+{
+    constexpr float Gravity = 9.81f;
+
+    // The tile plus its apron, in cell units: one cell is GridSize wide and
+    // terrain heights are scaled so slopes keep their world proportions
+    struct FErosionDomain
+    {
+        int32 NumX = 0;
+        int32 NumY = 0;
+        int32 Apron = 0;
+
+        // World cell coordinates of domain cell (0, 0), for seam-consistent rain
+        FIntPoint WorldCellOrigin = FIntPoint::ZeroValue;
+
+        TArray<float> Terrain;      // b
+        TArray<float> Water;        // d
+        TArray<float> Sediment;     // s
+        TArray<float> FluxL, FluxR, FluxT, FluxB;  // outflow towards x-1, x+1, y-1, y+1
+        TArray<float> VelocityX, VelocityY;
+
+        // Second buffers for the passes that read neighbours of what they write
+        TArray<float> TerrainNext;
+        TArray<float> SedimentNext;
+
+        int32 Index(int32 x, int32 y) const { return y * NumX + x; }
+
+        // Thermal erosion only needs Terrain and TerrainNext
+        void AllocateHydraulic()
+        {
+            const int32 Num = NumX * NumY;
+            for (TArray<float>* Buffer : { &Water, &Sediment, &FluxL, &FluxR, &FluxT, &FluxB, &VelocityX, &VelocityY })
+            {
+                Buffer->SetNumZeroed(Num);
+            }
+            SedimentNext.SetNumUninitialized(Num);
+        }
+    };
+
+    void HydraulicStep(FErosionDomain& D, const FTerrainErosionSettings& E, int32 Step)
+    {
+        const int32 NumX = D.NumX;
+        const int32 NumY = D.NumY;
+        const float Dt = E.TimeStep;
+
+        // --- Rain and outflow: each cell updates only its own water and pipes ---
+        TerrainParallel::ForEachRowBand(NumY, E.RowsPerBand, E.bParallel, TEXT("Terrain::ErosionBand"), [&](int32 RowBegin, int32 RowEnd)
+        {
+            for (int32 y = RowBegin; y < RowEnd; ++y)
+            {
+                for (int32 x = 0; x < NumX; ++x)
+                {
+                    const int32 i = D.Index(x, y);
+                    const float Rain = E.RainRate * (0.5f + TerrainHash::HashCell01(E.Seed, D.WorldCellOrigin.X + x, D.WorldCellOrigin.Y + y, static_cast<uint32>(Step)));
+                    D.Water[i] += Dt * Rain;
+                }
+            }
+        });
+
+        TerrainParallel::ForEachRowBand(NumY, E.RowsPerBand, E.bParallel, TEXT("Terrain::ErosionBand"), [&](int32 RowBegin, int32 RowEnd)
+        {
+            for (int32 y = RowBegin; y < RowEnd; ++y)
+            {
+                for (int32 x = 0; x < NumX; ++x)
+                {
+                    const int32 i = D.Index(x, y);
+                    const float Surface = D.Terrain[i] + D.Water[i];
+
+                    // Closed domain: no pipes across the outer edge
+                    auto Pipe = [&](float Flux, bool bOpen, int32 n)
+                    {
+                        return bOpen ? FMath::Max(0.0f, Flux + Dt * Gravity * (Surface - D.Terrain[n] - D.Water[n])) : 0.0f;
+                    };
+
+                    float L = Pipe(D.FluxL[i], x > 0, i - 1);
+                    float R = Pipe(D.FluxR[i], x < NumX - 1, i + 1);
+                    float T = Pipe(D.FluxT[i], y > 0, i - NumX);
+                    float B = Pipe(D.FluxB[i], y < NumY - 1, i + NumX);
+
+                    // Never drain more water than the cell holds
+                    const float Out = (L + R + T + B) * Dt;
+                    if (Out > D.Water[i] && Out > 0.0f)
+                    {
+                        const float K = D.Water[i] / Out;
+                        L *= K; R *= K; T *= K; B *= K;
+                    }
+
+                    D.FluxL[i] = L;
+                    D.FluxR[i] = R;
+                    D.FluxT[i] = T;
+                    D.FluxB[i] = B;
+                }
+            }
+        });
+
+        // --- Water depth and velocity from the neighbours' pipes (reads flux only) ---
+        TerrainParallel::ForEachRowBand(NumY, E.RowsPerBand, E.bParallel, TEXT("Terrain::ErosionBand"), [&](int32 RowBegin, int32 RowEnd)
+        {
+            for (int32 y = RowBegin; y < RowEnd; ++y)
+            {
+                for (int32 x = 0; x < NumX; ++x)
+                {
+                    const int32 i = D.Index(x, y);
+
+                    const float InL = (x > 0) ? D.FluxR[i - 1] : 0.0f;
+                    const float InR = (x < NumX - 1) ? D.FluxL[i + 1] : 0.0f;
+                    const float InT = (y > 0) ? D.FluxB[i - NumX] : 0.0f;
+                    const float InB = (y < NumY - 1) ? D.FluxT[i + NumX] : 0.0f;
+
+                    const float Inflow = InL + InR + InT + InB;
+                    const float Outflow = D.FluxL[i] + D.FluxR[i] + D.FluxT[i] + D.FluxB[i];
+
+                    const float Before = D.Water[i];
+                    const float After = FMath::Max(0.0f, Before + Dt * (Inflow - Outflow));
+                    D.Water[i] = After;
+
+                    const float Depth = 0.5f * (Before + After);
+                    const float FlowX = 0.5f * (InL - D.FluxL[i] + D.FluxR[i] - InR);
+                    const float FlowY = 0.5f * (InT - D.FluxT[i] + D.FluxB[i] - InB);
+
+                    D.VelocityX[i] = (Depth > UE_KINDA_SMALL_NUMBER) ? FlowX / Depth : 0.0f;
+                    D.VelocityY[i] = (Depth > UE_KINDA_SMALL_NUMBER) ? FlowY / Depth : 0.0f;
+                }
+            }
+        });
+
+        // --- Erosion and deposition (reads neighbour terrain, writes TerrainNext) ---
+        TerrainParallel::ForEachRowBand(NumY, E.RowsPerBand, E.bParallel, TEXT("Terrain::ErosionBand"), [&](int32 RowBegin, int32 RowEnd)
+        {
+            for (int32 y = RowBegin; y < RowEnd; ++y)
+            {
+                for (int32 x = 0; x < NumX; ++x)
+                {
+                    const int32 i = D.Index(x, y);
+
+                    const float GradX = 0.5f * (D.Terrain[D.Index(FMath::Min(x + 1, NumX - 1), y)] - D.Terrain[D.Index(FMath::Max(x - 1, 0), y)]);
+                    const float GradY = 0.5f * (D.Terrain[D.Index(x, FMath::Min(y + 1, NumY - 1))] - D.Terrain[D.Index(x, FMath::Max(y - 1, 0))]);
+                    const float GradSq = GradX * GradX + GradY * GradY;
+                    const float SinTilt = FMath::Max(FMath::Sqrt(GradSq / (1.0f + GradSq)), E.MinTilt);
+
+                    const float Speed = FMath::Sqrt(D.VelocityX[i] * D.VelocityX[i] + D.VelocityY[i] * D.VelocityY[i]);
+                    const float Capacity = E.SedimentCapacity * SinTilt * Speed;
+
+                    float Terrain = D.Terrain[i];
+                    float Sediment = D.Sediment[i];
+                    if (Capacity > Sediment)
+                    {
+                        const float Dissolved = E.DissolveRate * Dt * (Capacity - Sediment);
+                        Terrain -= Dissolved;
+                        Sediment += Dissolved;
+                    }
+                    else
+                    {
+                        const float Deposited = E.DepositRate * Dt * (Sediment - Capacity);
+                        Terrain += Deposited;
+                        Sediment -= Deposited;
+                    }
+
+                    D.TerrainNext[i] = Terrain;
+                    D.Sediment[i] = Sediment;
+                }
+            }
+        });
+        Swap(D.Terrain, D.TerrainNext);
+
+        // --- Sediment carried backwards along the velocity, then evaporation ---
+        TerrainParallel::ForEachRowBand(NumY, E.RowsPerBand, E.bParallel, TEXT("Terrain::ErosionBand"), [&](int32 RowBegin, int32 RowEnd)
+        {
+            for (int32 y = RowBegin; y < RowEnd; ++y)
+            {
+                for (int32 x = 0; x < NumX; ++x)
+                {
+                    const int32 i = D.Index(x, y);
+
+                    const float SrcX = FMath::Clamp(x - D.VelocityX[i] * Dt, 0.0f, static_cast<float>(NumX - 1));
+                    const float SrcY = FMath::Clamp(y - D.VelocityY[i] * Dt, 0.0f, static_cast<float>(NumY - 1));
+                    const int32 X0 = FMath::Min(FMath::FloorToInt32(SrcX), NumX - 2);
+                    const int32 Y0 = FMath::Min(FMath::FloorToInt32(SrcY), NumY - 2);
+                    const float Tx = SrcX - X0;
+                    const float Ty = SrcY - Y0;
+
+                    const float* Row0 = D.Sediment.GetData() + D.Index(X0, Y0);
+                    const float* Row1 = Row0 + NumX;
+                    D.SedimentNext[i] = FMath::Lerp(FMath::Lerp(Row0[0], Row0[1], Tx), FMath::Lerp(Row1[0], Row1[1], Tx), Ty);
+
+                    D.Water[i] *= FMath::Max(0.0f, 1.0f - E.EvaporationRate * Dt);
+                }
+            }
+        });
+        Swap(D.Sediment, D.SedimentNext);
+    }
+
+    // Height change of one cell from its 8 neighbours. Material moves across
+    // each pair by the part of their difference above the talus drop
+    // (TalusStraight/TalusDiagonal, cell units), in equal and opposite amounts,
+    // so every step conserves material and no cell depends on another's update.
+    //   max(d - T, 0) + min(d + T, 0),  d = neighbour - centre
+    FORCEINLINE float TalusExchange(float Centre, float Neighbour, float Talus)
+    {
+        const float Diff = Neighbour - Centre;
+        return FMath::Max(Diff - Talus, 0.0f) + FMath::Min(Diff + Talus, 0.0f);
+    }
+
+    FORCEINLINE VectorRegister4Float TalusExchange4(const VectorRegister4Float& Centre, const float* Neighbour, const VectorRegister4Float& Talus)
+    {
+        const VectorRegister4Float Diff = VectorSubtract(VectorLoad(Neighbour), Centre);
+        return VectorAdd(
+            VectorMax(VectorSubtract(Diff, Talus), VectorZeroFloat()),
+            VectorMin(VectorAdd(Diff, Talus), VectorZeroFloat()));
+    }
+
+    // One thermal step from Terrain into TerrainNext. The outermost ring of
+    // the domain is copied through unchanged so the stencil never clamps.
+    void ThermalStep(FErosionDomain& D, const FTerrainErosionSettings& E, float TalusStraight, float TalusDiagonal)
+    {
+        const int32 NumX = D.NumX;
+        const int32 NumY = D.NumY;
+
+        // 8 neighbours share the rate, which keeps the explicit step stable for ThermalRate <= 1
+        const float Rate = FMath::Clamp(E.ThermalRate, 0.0f, 1.0f) * 0.125f;
+
+        TerrainParallel::ForEachRowBand(NumY, E.RowsPerBand, E.bParallel, TEXT("Terrain::ErosionBand"), [&](int32 RowBegin, int32 RowEnd)
+        {
+            const VectorRegister4Float Rate4 = VectorSetFloat1(Rate);
+            const VectorRegister4Float Straight4 = VectorSetFloat1(TalusStraight);
+            const VectorRegister4Float Diagonal4 = VectorSetFloat1(TalusDiagonal);
+
+            for (int32 y = RowBegin; y < RowEnd; ++y)
+            {
+                const float* Row = D.Terrain.GetData() + D.Index(0, y);
+                float* Out = D.TerrainNext.GetData() + D.Index(0, y);
+
+                if (y == 0 || y == NumY - 1)
+                {
+                    FMemory::Memcpy(Out, Row, NumX * sizeof(float));
+                    continue;
+                }
+
+                const float* Up = Row - NumX;
+                const float* Down = Row + NumX;
+
+                Out[0] = Row[0];
+                Out[NumX - 1] = Row[NumX - 1];
+
+                // Four cells per iteration; every load is unaligned because the
+                // neighbours sit one float either side
+                int32 x = 1;
+                for (; x + 4 <= NumX - 1; x += 4)
+                {
+                    const VectorRegister4Float Centre = VectorLoad(Row + x);
+
+                    VectorRegister4Float Sum = TalusExchange4(Centre, Row + x - 1, Straight4);
+                    Sum = VectorAdd(Sum, TalusExchange4(Centre, Row + x + 1, Straight4));
+                    Sum = VectorAdd(Sum, TalusExchange4(Centre, Up + x, Straight4));
+                    Sum = VectorAdd(Sum, TalusExchange4(Centre, Down + x, Straight4));
+                    Sum = VectorAdd(Sum, TalusExchange4(Centre, Up + x - 1, Diagonal4));
+                    Sum = VectorAdd(Sum, TalusExchange4(Centre, Up + x + 1, Diagonal4));
+                    Sum = VectorAdd(Sum, TalusExchange4(Centre, Down + x - 1, Diagonal4));
+                    Sum = VectorAdd(Sum, TalusExchange4(Centre, Down + x + 1, Diagonal4));
+
+                    VectorStore(VectorMultiplyAdd(Sum, Rate4, Centre), Out + x);
+                }
+
+                // Same sums in the same order for the last few cells
+                for (; x < NumX - 1; ++x)
+                {
+                    const float Centre = Row[x];
+
+                    float Sum = TalusExchange(Centre, Row[x - 1], TalusStraight);
+                    Sum += TalusExchange(Centre, Row[x + 1], TalusStraight);
+                    Sum += TalusExchange(Centre, Up[x], TalusStraight);
+                    Sum += TalusExchange(Centre, Down[x], TalusStraight);
+                    Sum += TalusExchange(Centre, Up[x - 1], TalusDiagonal);
+                    Sum += TalusExchange(Centre, Up[x + 1], TalusDiagonal);
+                    Sum += TalusExchange(Centre, Down[x - 1], TalusDiagonal);
+                    Sum += TalusExchange(Centre, Down[x + 1], TalusDiagonal);
+
+                    Out[x] = Centre + Sum * Rate;
+                }
+            }
+        });
+        Swap(D.Terrain, D.TerrainNext);
+    }
+}
+
+bool FTerrainErosionSettings::operator==(const FTerrainErosionSettings& Other) const
+{
+    // Disabled settings leave the heightmap alone whatever their values
+    if (!IsEnabled() && !Other.IsEnabled())
+    {
+        return true;
+    }
+
+    // bParallel and RowsPerBand only split the work
+    return HydraulicIterations == Other.HydraulicIterations
+        && TimeStep == Other.TimeStep
+        && RainRate == Other.RainRate
+        && SedimentCapacity == Other.SedimentCapacity
+        && DissolveRate == Other.DissolveRate
+        && DepositRate == Other.DepositRate
+        && EvaporationRate == Other.EvaporationRate
+        && MinTilt == Other.MinTilt
+        && ThermalIterations == Other.ThermalIterations
+        && TalusAngleDegrees == Other.TalusAngleDegrees
+        && ThermalRate == Other.ThermalRate
+        && TimeBudgetMs == Other.TimeBudgetMs
+        && Seed == Other.Seed
+        && ApronCells == Other.ApronCells
+        && BorderFalloffCells == Other.BorderFalloffCells;
+}
+
+void TerrainErosion::Erode(const FLandmassBuildSettings& Settings, TArray<float>& InOutHeights)
+{
+    const FTerrainErosionSettings& E = Settings.Erosion;
+    const int32 MapWidth = Settings.MapWidth;
+    const int32 MapHeight = Settings.MapHeight;
+
+    // A flat map has nothing to erode
+    if (!E.IsEnabled() || Settings.bFlatHeightMap || MapWidth < 2 || MapHeight < 2 || InOutHeights.Num() != MapWidth * MapHeight ||
+        Settings.GridSize <= 0.0f || Settings.HeightMultiplier <= 0.0f)
+    {
+        return;
+    }
+
+    TERRAIN_STAGE_SCOPE(Erosion);
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    // Normalized height -> cell units, and back
+    const float ToCells = Settings.HeightMultiplier / Settings.GridSize;
+    const float FromCells = 1.0f / ToCells;
+
+    FErosionDomain D;
+    D.Apron = FMath::Max(E.ApronCells, 0);
+    D.NumX = MapWidth + 2 * D.Apron;
+    D.NumY = MapHeight + 2 * D.Apron;
+    D.WorldCellOrigin = FIntPoint(
+        FMath::RoundToInt32(Settings.Noise.BaseWorldX) - D.Apron,
+        FMath::RoundToInt32(Settings.Noise.BaseWorldY) - D.Apron);
+    D.Terrain.SetNumUninitialized(D.NumX * D.NumY);
+    D.TerrainNext.SetNumUninitialized(D.NumX * D.NumY);
+    if (E.HydraulicIterations > 0)
+    {
+        D.AllocateHydraulic();
+    }
+
+    // --- Terrain: the tile, plus apron sampled from the same noise the neighbours use ---
+    TerrainParallel::ForEachRowBand(D.NumY, E.RowsPerBand, E.bParallel, TEXT("Terrain::ErosionBand"), [&](int32 RowBegin, int32 RowEnd)
+    {
+        for (int32 y = RowBegin; y < RowEnd; ++y)
+        {
+            const int32 MapY = y - D.Apron;
+            for (int32 x = 0; x < D.NumX; ++x)
+            {
+                const int32 MapX = x - D.Apron;
+                const bool bInside = MapX >= 0 && MapX < MapWidth && MapY >= 0 && MapY < MapHeight;
+                const float Height01 = bInside ? InOutHeights[MapY * MapWidth + MapX] : Settings.Noise.SampleHeight(MapX, MapY);
+                D.Terrain[D.Index(x, y)] = Height01 * ToCells;
+            }
+        }
+    });
+
+    // Both passes share the budget; checked between whole steps only
+    const int32 TotalSteps = FMath::Max(E.HydraulicIterations, 0) + FMath::Max(E.ThermalIterations, 0);
+    int32 StepsRun = 0;
+    auto IsOverBudget = [&]()
+    {
+        if (E.TimeBudgetMs > 0.0f && (FPlatformTime::Seconds() - StartTime) * 1000.0 > E.TimeBudgetMs)
+        {
+            UE_LOG(LogProceduralTerrain, Warning, TEXT("%s: erosion stopped at its %.0f ms budget after %d of %d steps"),
+                *Settings.DebugName, E.TimeBudgetMs, StepsRun, TotalSteps);
+            return true;
+        }
+        return false;
+    };
+
+    bool bOverBudget = false;
+    for (int32 Step = 0; Step < E.HydraulicIterations; ++Step)
+    {
+        if (IsOverBudget())
+        {
+            bOverBudget = true;
+            break;
+        }
+
+        HydraulicStep(D, E, Step);
+        ++StepsRun;
+    }
+
+    if (E.HydraulicIterations > 0)
+    {
+        // Settle what the water still carries
+        TerrainParallel::ForEachRowBand(D.NumY, E.RowsPerBand, E.bParallel, TEXT("Terrain::ErosionBand"), [&](int32 RowBegin, int32 RowEnd)
+        {
+            for (int32 i = D.Index(0, RowBegin); i < D.Index(0, RowEnd); ++i)
+            {
+                D.Terrain[i] += D.Sediment[i];
+            }
+        });
+    }
+
+    // Thermal runs last so it also knocks down the walls hydraulic carving leaves
+    const float TalusSlope = FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(E.TalusAngleDegrees, 0.0f, 89.0f)));
+    for (int32 Step = 0; Step < E.ThermalIterations && !bOverBudget; ++Step)
+    {
+        if (IsOverBudget())
+        {
+            break;
+        }
+
+        ThermalStep(D, E, TalusSlope, TalusSlope * UE_SQRT_2);
+        ++StepsRun;
+    }
+
+    // --- Back into the tile, fading out at the border ---
+    TerrainParallel::ForEachRowBand(MapHeight, E.RowsPerBand, E.bParallel, TEXT("Terrain::ErosionBand"), [&](int32 RowBegin, int32 RowEnd)
+    {
+        for (int32 MapY = RowBegin; MapY < RowEnd; ++MapY)
+        {
+            for (int32 MapX = 0; MapX < MapWidth; ++MapX)
+            {
+                const int32 i = D.Index(MapX + D.Apron, MapY + D.Apron);
+                const float Eroded01 = D.Terrain[i] * FromCells;
+
+                const int32 EdgeDistance = FMath::Min(FMath::Min(MapX, MapWidth - 1 - MapX), FMath::Min(MapY, MapHeight - 1 - MapY));
+                const float Weight = FLandmassHeightApron::GetBorderWeight(EdgeDistance, E.BorderFalloffCells);
+
+                float& Height01 = InOutHeights[MapY * MapWidth + MapX];
+                Height01 = FMath::Clamp(FMath::Lerp(Height01, Eroded01, Weight), 0.0f, 1.0f);
+            }
+        }
+    });
+
+    UE_LOG(LogProceduralTerrain, Verbose, TEXT("%s: %d erosion steps on %dx%d (apron %d) in %.2f ms"),
+        *Settings.DebugName, StepsRun, MapWidth, MapHeight, D.Apron,
+        (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
@@ -0,0 +1,79 @@
+// TerrainErosion.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FLandmassBuildSettings;
+
+// Parameters of the erosion passes run on the normalized heightmap between the
+// noise stage and the mesh. Plain data, copied into FLandmassBuildSettings.
+struct PCG_EXPLORATION_UE_API FTerrainErosionSettings
+{
+    // ------------ Hydraulic (virtual pipes) ------------
+    // Simulation steps; 0 disables hydraulic erosion
+    int32 HydraulicIterations = 0;
+
+    // Seconds of simulated time per step
+    float TimeStep = 0.02f;
+
+    // Water added per cell per second, in cell-height units
+    float RainRate = 0.012f;
+
+    // Sediment a unit of flowing water can carry per unit of speed and slope
+    float SedimentCapacity = 1.0f;
+
+    // Fractions per second of the capacity surplus/deficit dissolved or deposited
+    float DissolveRate = 0.5f;
+    float DepositRate = 1.0f;
+
+    // Fraction of water lost per second
+    float EvaporationRate = 0.015f;
+
+    // Slope floor in the capacity term, so flat water still carries some sediment
+    float MinTilt = 0.05f;
+
+    // ------------ Thermal (talus relaxation) ------------
+    // 8-neighbour stencil steps run after the hydraulic ones; 0 disables them
+    int32 ThermalIterations = 0;
+
+    // Steepest slope that holds; material above it slides to the lower neighbour
+    float TalusAngleDegrees = 40.0f;
+
+    // Fraction of the excess moved per step, in (0, 1]
+    float ThermalRate = 0.5f;
+
+    // ------------ Shared ------------
+    // Wall-clock cap on the whole pass; 0 = none. Hitting it ends the pass
+    // after a whole step, which makes the result timing dependent.
+    float TimeBudgetMs = 0.0f;
+
+    // Rain variation is hashed from this and world cell coordinates
+    int32 Seed = 0;
+
+    // Cells of neighbouring terrain simulated around the tile, so flow near
+    // the border behaves as it would on the neighbour's side
+    int32 ApronCells = 16;
+
+    // Erosion fades to nothing over this many cells (at least 1) inside the
+    // two raw border rings; see FLandmassHeightApron::GetBorderWeight. The
+    // apron carries the simulation past the border, so this can stay short
+    int32 BorderFalloffCells = 2;
+
+    // Rows handed to each task; the result is the same either way
+    bool  bParallel = true;
+    int32 RowsPerBand = 16;
+
+    bool IsEnabled() const { return HydraulicIterations > 0 || ThermalIterations > 0; }
+
+    bool operator==(const FTerrainErosionSettings& Other) const;
+    bool operator!=(const FTerrainErosionSettings& Other) const { return !(*this == Other); }
+};
+
+namespace TerrainErosion
+{
+    // Erodes a MapWidth x MapHeight normalized heightmap in place. Every pass
+    // reads one set of buffers and writes another, so the result is the same
+    // for any thread count (given the same TimeBudgetMs outcome).
+    PCG_EXPLORATION_UE_API void Erode(const FLandmassBuildSettings& Settings, TArray<float>& InOutHeights);
+}
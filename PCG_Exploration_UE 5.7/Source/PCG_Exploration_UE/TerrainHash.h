@@ -0,0 +1,31 @@
+// TerrainHash.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace TerrainHash
+{
+    // murmur3 finalizer over a seed, a world cell and a salt. Pure function of
+    // its inputs, so every tile draws the same value for a shared cell
+    inline uint32 HashCell(uint32 Seed, int32 CellX, int32 CellY, uint32 Salt)
+    {
+        uint32 H = Seed * 0x9E3779B1u;
+        H ^= static_cast<uint32>(CellX) * 0x85EBCA77u;
+        H ^= static_cast<uint32>(CellY) * 0xC2B2AE3Du;
+        H ^= Salt * 0x27D4EB2Fu;
+
+        H ^= H >> 16;
+        H *= 0x85EBCA6Bu;
+        H ^= H >> 13;
+        H *= 0xC2B2AE35u;
+        H ^= H >> 16;
+        return H;
+    }
+
+    // [0, 1) with 24 bits
+    inline float HashCell01(uint32 Seed, int32 CellX, int32 CellY, uint32 Salt)
+    {
+        return static_cast<float>(HashCell(Seed, CellX, CellY, Salt) >> 8) * (1.0f / 16777216.0f);
+    }
+}
@@ -0,0 +1,346 @@
+// TerrainHeightCache.cpp
+
+#include "TerrainHeightCache.h"
+#include "TerrainMeshBuilder.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/MemoryWriter.h"
+#include "PCG_Exploration_UE.h"
+#include "TerrainStats.h"
+
+static TAutoConsoleVariable<bool> CVarHeightCacheEnable(
+    TEXT("terrain.HeightCache.Enable"),
+    true,
+    TEXT("Load and store landmass heightmaps in Saved/TerrainCache instead of always sampling noise."));
+
+static TAutoConsoleVariable<int32> CVarHeightCacheMaxSizeMB(
+    TEXT("terrain.HeightCache.MaxSizeMB"),
+    256,
+    TEXT("Size cap of Saved/TerrainCache. Least recently used heightmaps are deleted past it (0 = no cap)."));
+
+static FAutoConsoleCommand CmdHeightCacheClear(
+    TEXT("terrain.HeightCache.Clear"),
+    TEXT("Deletes every heightmap in Saved/TerrainCache."),
+    FConsoleCommandDelegate::CreateStatic(&TerrainHeightCache::Clear));
+
+namespace
+{
+    // 'LMHC'
+    constexpr uint32 CacheMagic = 0x43484D4C;
+
+    // Bump when the file layout below changes
+    constexpr uint32 CacheFormatVersion = 1;
+
+    const TCHAR* CacheExtension = TEXT(".lmh");
+
+    struct FHeightCacheHeader
+    {
+        uint32 Magic = CacheMagic;
+        uint32 FormatVersion = CacheFormatVersion;
+        uint32 KernelVersion = TerrainNoise::KernelVersion;
+        int32  Width = 0;
+        int32  Height = 0;
+        uint32 KeySize = 0;
+    };
+
+    // Header, then the key bytes (kept to rule out hash collisions), then
+    // Width * Height uint16 samples starting at a 4-byte boundary
+    int64 GetSamplesOffset(uint32 KeySize)
+    {
+        return Align(static_cast<int64>(sizeof(FHeightCacheHeader)) + KeySize, 4);
+    }
+
+    FString GetCacheDir()
+    {
+        return FPaths::ProjectSavedDir() / TEXT("TerrainCache");
+    }
+
+    // Sizes and last use of every entry, so a Store doesn't rescan the
+    // directory. Filled by one scan on first use and kept current after that.
+    struct FCacheIndex
+    {
+        struct FEntry
+        {
+            FDateTime LastUsed;
+            int64 Size = 0;
+        };
+
+        TMap<FString, FEntry> Entries;
+        int64 TotalBytes = 0;
+        bool bScanned = false;
+
+        void EnsureScanned()
+        {
+            if (bScanned)
+            {
+                return;
+            }
+            bScanned = true;
+
+            IFileManager::Get().IterateDirectoryStat(*GetCacheDir(), [this](const TCHAR* Path, const FFileStatData& Stat)
+            {
+                if (!Stat.bIsDirectory && FPaths::GetExtension(Path, true) == CacheExtension)
+                {
+                    // Modification time doubles as last use; hits touch it in Load
+                    Set(Path, Stat.FileSize, Stat.ModificationTime);
+                }
+                return true;
+            });
+        }
+
+        void Set(const FString& Path, int64 Size, const FDateTime& LastUsed)
+        {
+            FEntry& Entry = Entries.FindOrAdd(Path);
+            TotalBytes += Size - Entry.Size;
+            Entry.Size = Size;
+            Entry.LastUsed = LastUsed;
+        }
+
+        void Remove(const FString& Path)
+        {
+            FEntry Entry;
+            if (Entries.RemoveAndCopyValue(Path, Entry))
+            {
+                TotalBytes -= Entry.Size;
+            }
+        }
+
+        void Reset()
+        {
+            Entries.Reset();
+            TotalBytes = 0;
+        }
+    };
+
+    // Guards the index, and eviction so two workers don't delete under each other
+    FCriticalSection IndexLock;
+    FCacheIndex Index;
+
+    // Everything the noise stage reads, in a fixed order
+    void BuildKey(const FLandmassBuildSettings& Settings, TArray<uint8>& OutKey)
+    {
+        FMemoryWriter Ar(OutKey);
+
+        uint32 KernelVersion = TerrainNoise::KernelVersion;
+        int32 Width = Settings.MapWidth;
+        int32 Height = Settings.MapHeight;
+        FTerrainNoiseSampler Sampler = Settings.Noise;
+
+        Ar << KernelVersion << Width << Height;
+        Ar << Sampler.BaseWorldX << Sampler.BaseWorldY << Sampler.Offset;
+        Ar << Sampler.NoiseScale << Sampler.Octaves << Sampler.Persistence << Sampler.Lacunarity;
+        Ar << Sampler.OctaveOffsets;
+        // The kernel that actually runs, not the one asked for
+        bool bVectorKernel = Sampler.bUseVectorKernel && TerrainNoise::IsVectorKernelAvailable();
+        Ar << bVectorKernel;
+    }
+
+    FString GetEntryPath(const TArray<uint8>& Key)
+    {
+        FSHAHash Hash;
+        FSHA1::HashBuffer(Key.GetData(), Key.Num(), Hash.Hash);
+        return GetCacheDir() / (Hash.ToString() + CacheExtension);
+    }
+
+    // Caller holds IndexLock
+    void EvictToCap()
+    {
+        const int64 MaxBytes = static_cast<int64>(CVarHeightCacheMaxSizeMB.GetValueOnAnyThread()) * 1024 * 1024;
+        if (MaxBytes <= 0 || Index.TotalBytes <= MaxBytes)
+        {
+            return;
+        }
+
+        TArray<TPair<FDateTime, FString>> ByLastUse;
+        ByLastUse.Reserve(Index.Entries.Num());
+        for (const TPair<FString, FCacheIndex::FEntry>& Entry : Index.Entries)
+        {
+            ByLastUse.Emplace(Entry.Value.LastUsed, Entry.Key);
+        }
+        ByLastUse.Sort([](const TPair<FDateTime, FString>& A, const TPair<FDateTime, FString>& B) { return A.Key < B.Key; });
+
+        for (const TPair<FDateTime, FString>& Entry : ByLastUse)
+        {
+            if (Index.TotalBytes <= MaxBytes)
+            {
+                break;
+            }
+
+            if (IFileManager::Get().Delete(*Entry.Value, false, false, true))
+            {
+                Index.Remove(Entry.Value);
+            }
+        }
+    }
+}
+
+bool TerrainHeightCache::IsCacheable(const FLandmassBuildSettings& Settings)
+{
+    return CVarHeightCacheEnable.GetValueOnAnyThread()
+        && !Settings.bFlatHeightMap
+        && Settings.MapWidth >= 2 && Settings.MapHeight >= 2;
+}
+
+bool TerrainHeightCache::Load(const FLandmassBuildSettings& Settings, TArray<float>& OutHeights)
+{
+    if (!IsCacheable(Settings))
+    {
+        return false;
+    }
+
+    TERRAIN_STAGE_SCOPE(HeightCache);
+
+    TArray<uint8> Key;
+    BuildKey(Settings, Key);
+    const FString Path = GetEntryPath(Key);
+
+    const int32 NumVerts = Settings.MapWidth * Settings.MapHeight;
+    bool bHit = false;
+    bool bDamaged = false;
+
+    {
+        IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+        TUniquePtr<IMappedFileHandle> Handle(PlatformFile.OpenMapped(*Path));
+        if (!Handle)
+        {
+            return false;
+        }
+
+        const int64 FileSize = Handle->GetFileSize();
+        const int64 SamplesOffset = GetSamplesOffset(Key.Num());
+        const int64 ExpectedSize = SamplesOffset + static_cast<int64>(NumVerts) * sizeof(uint16);
+
+        TUniquePtr<IMappedFileRegion> Region(FileSize == ExpectedSize ? Handle->MapRegion(0, FileSize) : nullptr);
+        if (!Region)
+        {
+            bDamaged = true;
+        }
+        else
+        {
+            const uint8* Bytes = Region->GetMappedPtr();
+
+            FHeightCacheHeader Header;
+            FMemory::Memcpy(&Header, Bytes, sizeof(Header));
+
+            bDamaged = Header.Magic != CacheMagic
+                || Header.FormatVersion != CacheFormatVersion
+                || Header.KernelVersion != TerrainNoise::KernelVersion
+                || Header.Width != Settings.MapWidth
+                || Header.Height != Settings.MapHeight
+                || Header.KeySize != static_cast<uint32>(Key.Num())
+                || FMemory::Memcmp(Bytes + sizeof(Header), Key.GetData(), Key.Num()) != 0;
+
+            if (!bDamaged)
+            {
+                const uint16* Samples = reinterpret_cast<const uint16*>(Bytes + SamplesOffset);
+
+                OutHeights.SetNumUninitialized(NumVerts);
+                for (int32 i = 0; i < NumVerts; ++i)
+                {
+                    OutHeights[i] = Samples[i] * QuantizationStep;
+                }
+                bHit = true;
+            }
+        }
+    }
+
+    // File is unmapped by now, so it can be touched or removed
+    if (bHit)
+    {
+        const FDateTime Now = FDateTime::UtcNow();
+        IFileManager::Get().SetTimeStamp(*Path, Now);
+
+        FScopeLock Lock(&IndexLock);
+        Index.EnsureScanned();
+        if (FCacheIndex::FEntry* Entry = Index.Entries.Find(Path))
+        {
+            Entry->LastUsed = Now;
+        }
+
+        UE_LOG(LogProceduralTerrain, Verbose, TEXT("%s: heightmap loaded from %s"),
+            *Settings.DebugName, *FPaths::GetCleanFilename(Path));
+    }
+    else if (bDamaged)
+    {
+        UE_LOG(LogProceduralTerrain, Log, TEXT("%s: discarding stale or damaged height cache entry %s"),
+            *Settings.DebugName, *FPaths::GetCleanFilename(Path));
+
+        FScopeLock Lock(&IndexLock);
+        if (IFileManager::Get().Delete(*Path, false, false, true))
+        {
+            Index.Remove(Path);
+        }
+    }
+
+    return bHit;
+}
+
+void TerrainHeightCache::Store(const FLandmassBuildSettings& Settings, const TArray<float>& Heights)
+{
+    const int32 NumVerts = Settings.MapWidth * Settings.MapHeight;
+    if (!IsCacheable(Settings) || Heights.Num() != NumVerts)
+    {
+        return;
+    }
+
+    TERRAIN_STAGE_SCOPE(HeightCache);
+
+    TArray<uint8> Key;
+    BuildKey(Settings, Key);
+    const FString Path = GetEntryPath(Key);
+
+    FHeightCacheHeader Header;
+    Header.Width = Settings.MapWidth;
+    Header.Height = Settings.MapHeight;
+    Header.KeySize = Key.Num();
+
+    const int64 SamplesOffset = GetSamplesOffset(Key.Num());
+
+    TArray<uint8> Buffer;
+    Buffer.SetNumZeroed(static_cast<int32>(SamplesOffset + NumVerts * sizeof(uint16)));
+    FMemory::Memcpy(Buffer.GetData(), &Header, sizeof(Header));
+    FMemory::Memcpy(Buffer.GetData() + sizeof(Header), Key.GetData(), Key.Num());
+
+    uint16* Samples = reinterpret_cast<uint16*>(Buffer.GetData() + SamplesOffset);
+    for (int32 i = 0; i < NumVerts; ++i)
+    {
+        Samples[i] = static_cast<uint16>(FMath::RoundToInt(FMath::Clamp(Heights[i], 0.0f, 1.0f) * 65535.0f));
+    }
+
+    // Write aside and rename, so a concurrent Load never maps a partial file
+    const FString TempPath = FPaths::SetExtension(Path, FGuid::NewGuid().ToString() + TEXT(".tmp"));
+    if (!FFileHelper::SaveArrayToFile(Buffer, *TempPath))
+    {
+        UE_LOG(LogProceduralTerrain, Warning, TEXT("%s: could not write height cache entry %s"),
+            *Settings.DebugName, *TempPath);
+        return;
+    }
+
+    if (!IFileManager::Get().Move(*Path, *TempPath, true, true))
+    {
+        IFileManager::Get().Delete(*TempPath, false, false, true);
+        return;
+    }
+
+    FScopeLock Lock(&IndexLock);
+    Index.EnsureScanned();
+    Index.Set(Path, Buffer.Num(), FDateTime::UtcNow());
+    EvictToCap();
+}
+
+void TerrainHeightCache::Clear()
+{
+    FScopeLock Lock(&IndexLock);
+    IFileManager::Get().DeleteDirectory(*GetCacheDir(), false, true);
+
+    // Nothing left to scan
+    Index.Reset();
+    Index.bScanned = true;
+}
@@ -0,0 +1,39 @@
+// TerrainHeightCache.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FLandmassBuildSettings;
+
+// Content-addressed store of built heightmaps under Saved/TerrainCache.
+//
+// Entries are named by a hash of everything the noise stage reads (sampler
+// parameters, map size and TerrainNoise::KernelVersion) and hold the heights
+// quantized to 16 bits. Lookups memory-map the file, so a warm start costs a
+// dequantize pass instead of a noise pass. The directory is capped by
+// terrain.HeightCache.MaxSizeMB; least recently used entries go first. Entry
+// sizes are tracked in memory after one scan of the directory, so only the
+// first cache access pays for a directory listing.
+//
+// All functions are safe to call from any thread.
+namespace TerrainHeightCache
+{
+    // One quantization step in normalized height units
+    constexpr float QuantizationStep = 1.0f / 65535.0f;
+
+    // False when the cache is disabled (terrain.HeightCache.Enable 0) or the
+    // settings describe a flat map, which is cheaper to build than to load
+    PCG_EXPLORATION_UE_API bool IsCacheable(const FLandmassBuildSettings& Settings);
+
+    // Fills OutHeights from a matching entry. Returns false on a miss, or if
+    // the entry was written by another kernel version or is damaged (in
+    // which case it is deleted).
+    PCG_EXPLORATION_UE_API bool Load(const FLandmassBuildSettings& Settings, TArray<float>& OutHeights);
+
+    // Writes an entry for these settings, then evicts down to the size cap
+    PCG_EXPLORATION_UE_API void Store(const FLandmassBuildSettings& Settings, const TArray<float>& Heights);
+
+    // Deletes every entry
+    PCG_EXPLORATION_UE_API void Clear();
+}
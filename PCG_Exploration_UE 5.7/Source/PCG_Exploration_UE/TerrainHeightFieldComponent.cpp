@@ -0,0 +1,207 @@
+// TerrainHeightFieldComponent.cpp
+
+#include "TerrainHeightFieldComponent.h"
+#include "TerrainMeshBuilder.h"
+#include "TerrainStats.h"
+
+#include "Chaos/HeightField.h"
+#include "Chaos/ImplicitObjectTransformed.h"
+#include "Chaos/ShapeInstance.h"
+#include "Engine/World.h"
+#include "Physics/PhysicsFiltering.h"
+#include "Physics/PhysicsInterfaceCore.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+
+UTerrainHeightFieldComponent::UTerrainHeightFieldComponent(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    PrimaryComponentTick.bCanEverTick = false;
+
+    SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+    SetGenerateOverlapEvents(false);
+    bHiddenInGame = true;
+    SetCastShadow(false);
+}
+
+void UTerrainHeightFieldComponent::SetHeightField(const FLandmassCollisionHeightField& HeightField)
+{
+    TERRAIN_STAGE_SCOPE(Collision);
+
+    const int32 NumSamples = HeightField.NumX * HeightField.NumY;
+    if (HeightField.NumX < 2 || HeightField.NumY < 2 || HeightField.Heights.Num() != NumSamples)
+    {
+        ClearHeightField();
+        return;
+    }
+
+    SampleHeights.SetNumUninitialized(NumSamples);
+    for (int32 i = 0; i < NumSamples; ++i)
+    {
+        SampleHeights[i] = HeightField.Heights[i];
+    }
+    NumX = HeightField.NumX;
+    NumY = HeightField.NumY;
+    Spacing = HeightField.Spacing;
+
+    // Built against the current scale when the physics state is recreated
+    Geometry = nullptr;
+
+    LocalBounds = FBox(
+        FVector(0.0, 0.0, HeightField.MinHeight),
+        FVector((HeightField.NumX - 1) * HeightField.Spacing.X, (HeightField.NumY - 1) * HeightField.Spacing.Y, HeightField.MaxHeight)
+    );
+
+    UpdateBounds();
+    RecreatePhysicsState();
+}
+
+void UTerrainHeightFieldComponent::ClearHeightField()
+{
+    SampleHeights.Empty();
+    NumX = 0;
+    NumY = 0;
+    Geometry = nullptr;
+    LocalBounds = FBox(ForceInit);
+
+    UpdateBounds();
+    RecreatePhysicsState();
+}
+
+FBoxSphereBounds UTerrainHeightFieldComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+    if (!LocalBounds.IsValid)
+    {
+        return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.0);
+    }
+
+    return FBoxSphereBounds(LocalBounds).TransformBy(LocalToWorld);
+}
+
+bool UTerrainHeightFieldComponent::ShouldCreatePhysicsState() const
+{
+    return HasHeightField() && Super::ShouldCreatePhysicsState();
+}
+
+void UTerrainHeightFieldComponent::BuildGeometry(const FVector& WorldScale)
+{
+    // Chaos rows run along Y and columns along X, matching the row-major heightmap
+    const Chaos::FVec3 Scale(Spacing.X * WorldScale.X, Spacing.Y * WorldScale.Y, WorldScale.Z);
+    Geometry = MakeImplicitObjectPtr<Chaos::FHeightField>(CopyTemp(SampleHeights), TArray<uint8>(), NumY, NumX, Scale);
+    BakedScale = WorldScale;
+}
+
+void UTerrainHeightFieldComponent::OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+    // The body is moved here rather than by the base class, whose body scale
+    // update doesn't know the scale lives in the heightfield
+    Super::OnUpdateTransform(UpdateTransformFlags | EUpdateTransformFlags::SkipPhysicsUpdate, Teleport);
+
+    if (!bPhysicsStateCreated || EnumHasAnyFlags(UpdateTransformFlags, EUpdateTransformFlags::SkipPhysicsUpdate))
+    {
+        return;
+    }
+
+    if (!BakedScale.Equals(GetComponentTransform().GetScale3D()))
+    {
+        RecreatePhysicsState();
+    }
+    else
+    {
+        BodyInstance.SetBodyTransform(GetComponentTransform(), Teleport);
+    }
+}
+
+void UTerrainHeightFieldComponent::OnCreatePhysicsState()
+{
+    // Skip UPrimitiveComponent's body setup path; the body is built by hand below
+    USceneComponent::OnCreatePhysicsState();
+
+    UWorld* World = GetWorld();
+    FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
+    if (!PhysScene || !HasHeightField() || BodyInstance.IsValidBodyInstance())
+    {
+        return;
+    }
+
+    // The world scale goes into the heightfield's own scale, so the body only
+    // carries location and rotation
+    FTransform BodyTransform = GetComponentTransform();
+    if (!Geometry.IsValid() || !BakedScale.Equals(BodyTransform.GetScale3D()))
+    {
+        BuildGeometry(BodyTransform.GetScale3D());
+    }
+    BodyTransform.SetScale3D(FVector::OneVector);
+
+    FActorCreationParams Params;
+    Params.InitialTM = BodyTransform;
+    Params.bQueryOnly = false;
+    Params.bStatic = true;
+    Params.Scene = PhysScene;
+
+    FPhysicsActorHandle PhysHandle;
+    FPhysicsInterface::CreateActor(Params, PhysHandle);
+    Chaos::FRigidBodyHandle_External& Body_External = PhysHandle->GetGameThreadAPI();
+
+    Chaos::FImplicitObjectPtr ShapeGeometry = MakeImplicitObjectPtr<Chaos::TImplicitObjectTransformed<Chaos::FReal, 3>>(
+        Geometry, Chaos::FRigidTransform3(FTransform::Identity));
+
+    TUniquePtr<Chaos::FPerShapeData> Shape = Chaos::FShapeInstanceProxy::Make(0, ShapeGeometry);
+
+    // One shape answers both simple and complex queries
+    FCollisionFilterData QueryFilterData;
+    FCollisionFilterData SimFilterData;
+    CreateShapeFilterData(static_cast<uint8>(GetCollisionObjectType()), FMaskFilter(0), GetOwner() ? GetOwner()->GetUniqueID() : 0,
+        GetCollisionResponseToChannels(), GetUniqueID(), 0, QueryFilterData, SimFilterData, false, false, true);
+    QueryFilterData.Word3 |= (EPDF_SimpleCollision | EPDF_ComplexCollision);
+    SimFilterData.Word3 |= (EPDF_SimpleCollision | EPDF_ComplexCollision);
+
+    Shape->SetQueryData(QueryFilterData);
+    Shape->SetSimData(SimFilterData);
+    Shape->SetQueryEnabled(CollisionEnabledHasQuery(GetCollisionEnabled()));
+    Shape->SetSimEnabled(CollisionEnabledHasPhysics(GetCollisionEnabled()));
+
+    if (UPhysicalMaterial* PhysMaterial = BodyInstance.GetSimplePhysicalMaterial())
+    {
+        Shape->SetMaterial(PhysMaterial->GetPhysicsMaterial());
+    }
+
+    Shape->UpdateShapeBounds(Chaos::FRigidTransform3(Body_External.GetX(), Body_External.GetR()));
+
+    Chaos::FShapesArray Shapes;
+    Shapes.Emplace(MoveTemp(Shape));
+
+    Body_External.SetGeometry(ShapeGeometry);
+    Body_External.MergeShapesArray(MoveTemp(Shapes));
+
+    BodyInstance.PhysicsUserData = FPhysicsUserData(&BodyInstance);
+    BodyInstance.OwnerComponent = this;
+    BodyInstance.SetPhysicsActorHandle(PhysHandle);
+    Body_External.SetUserData(&BodyInstance.PhysicsUserData);
+
+    TArray<FPhysicsActorHandle> Actors;
+    Actors.Add(PhysHandle);
+    FPhysicsCommand::ExecuteWrite(PhysScene, [PhysScene, &Actors]()
+    {
+        // Immediate insertion so traces hit the tile on the same frame
+        PhysScene->AddActorsToScene_AssumesLocked(Actors, true);
+    });
+
+    PhysScene->AddToComponentMaps(this, PhysHandle);
+}
+
+void UTerrainHeightFieldComponent::OnDestroyPhysicsState()
+{
+    UWorld* World = GetWorld();
+    FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
+
+    FPhysicsActorHandle& ActorHandle = BodyInstance.GetPhysicsActorHandle();
+    if (PhysScene && FPhysicsInterface::IsValid(ActorHandle))
+    {
+        PhysScene->RemoveFromComponentMaps(ActorHandle);
+    }
+
+    // Terminates the body and releases the actor
+    Super::OnDestroyPhysicsState();
+}
@@ -0,0 +1,59 @@
+// TerrainHeightFieldComponent.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/PrimitiveComponent.h"
+#include "Chaos/ImplicitFwd.h"
+#include "TerrainHeightFieldComponent.generated.h"
+
+struct FLandmassCollisionHeightField;
+
+// Collision-only component that gives a landmass a Chaos heightfield body
+// instead of cooked trimesh collision. The heightfield is built directly from
+// sampled heights, so there is no cooking step: a new body is in the physics
+// scene as soon as SetHeightField returns.
+UCLASS(ClassGroup = (Terrain), meta = (BlueprintSpawnableComponent))
+class PCG_EXPLORATION_UE_API UTerrainHeightFieldComponent : public UPrimitiveComponent
+{
+    GENERATED_BODY()
+
+public:
+    UTerrainHeightFieldComponent(const FObjectInitializer& ObjectInitializer);
+
+    // Replaces the collision surface; samples are in component space
+    void SetHeightField(const FLandmassCollisionHeightField& HeightField);
+
+    // Removes the body; the component stays registered
+    void ClearHeightField();
+
+    bool HasHeightField() const { return SampleHeights.Num() > 0; }
+
+    virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+    virtual bool ShouldCreatePhysicsState() const override;
+
+protected:
+    // The body is created by hand around Geometry; there is no UBodySetup
+    virtual void OnCreatePhysicsState() override;
+    virtual void OnDestroyPhysicsState() override;
+
+    // Rebuilds the body when the world scale changes; other moves just move it
+    virtual void OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport) override;
+
+private:
+    // Builds Geometry for the given world scale
+    void BuildGeometry(const FVector& WorldScale);
+
+    // Component-space samples from the last SetHeightField
+    TArray<Chaos::FReal> SampleHeights;
+    int32 NumX = 0;
+    int32 NumY = 0;
+    FVector2f Spacing = FVector2f::ZeroVector;
+
+    // Chaos::FHeightField with Spacing and BakedScale folded into its scale,
+    // since the body transform can't carry scale
+    Chaos::FImplicitObjectPtr Geometry;
+    FVector BakedScale = FVector::OneVector;
+
+    FBox LocalBounds = FBox(ForceInit);
+};
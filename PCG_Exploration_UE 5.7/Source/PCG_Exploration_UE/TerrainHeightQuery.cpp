@@ -0,0 +1,228 @@
+// TerrainHeightQuery.cpp
+
+#include "TerrainHeightQuery.h"
+
+#include "Math/VectorRegister.h"
+
+namespace
+{
+    // Corner heights and in-cell fractions for up to four points. There is no
+    // gather on SSE/NEON, so the corner loads are scalar; the coordinate and
+    // interpolation math around them is 4-wide.
+    struct FCellLanes
+    {
+        alignas(16) float H00[4];
+        alignas(16) float H10[4];
+        alignas(16) float H01[4];
+        alignas(16) float H11[4];
+        alignas(16) float Tx[4];
+        alignas(16) float Ty[4];
+
+        // Clamped position in the heightmap frame, in grid units
+        alignas(16) float GridX[4];
+        alignas(16) float GridY[4];
+    };
+
+    void GatherLanes(const FTerrainHeightQuery& Query, const FVector2D* Points, int32 NumPoints, FCellLanes& Out)
+    {
+        // Into the heightmap frame in double, then grid units in float
+        const double PlaneZ = Query.Transform.GetLocation().Z;
+        alignas(16) float LocalX[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        alignas(16) float LocalY[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int32 Lane = 0; Lane < NumPoints; ++Lane)
+        {
+            const FVector Local = Query.Transform.InverseTransformPosition(FVector(Points[Lane].X, Points[Lane].Y, PlaneZ));
+            LocalX[Lane] = static_cast<float>(Local.X);
+            LocalY[Lane] = static_cast<float>(Local.Y);
+        }
+
+        const VectorRegister4Float Zero = VectorZeroFloat();
+        const VectorRegister4Float InvGrid = VectorSetFloat1(1.0f / Query.GridSize);
+        const VectorRegister4Float MaxX = VectorSetFloat1(static_cast<float>(Query.MapWidth - 1));
+        const VectorRegister4Float MaxY = VectorSetFloat1(static_cast<float>(Query.MapHeight - 1));
+        const VectorRegister4Float MaxCellX = VectorSetFloat1(static_cast<float>(Query.MapWidth - 2));
+        const VectorRegister4Float MaxCellY = VectorSetFloat1(static_cast<float>(Query.MapHeight - 2));
+
+        const VectorRegister4Float GridX = VectorMin(VectorMax(VectorMultiply(VectorLoadAligned(LocalX), InvGrid), Zero), MaxX);
+        const VectorRegister4Float GridY = VectorMin(VectorMax(VectorMultiply(VectorLoadAligned(LocalY), InvGrid), Zero), MaxY);
+
+        // The far edge belongs to the last cell, at fraction 1
+        const VectorRegister4Float CellX = VectorMin(VectorFloor(GridX), MaxCellX);
+        const VectorRegister4Float CellY = VectorMin(VectorFloor(GridY), MaxCellY);
+
+        VectorStoreAligned(GridX, Out.GridX);
+        VectorStoreAligned(GridY, Out.GridY);
+        VectorStoreAligned(VectorSubtract(GridX, CellX), Out.Tx);
+        VectorStoreAligned(VectorSubtract(GridY, CellY), Out.Ty);
+
+        alignas(16) float CellXs[4];
+        alignas(16) float CellYs[4];
+        VectorStoreAligned(CellX, CellXs);
+        VectorStoreAligned(CellY, CellYs);
+
+        const float* Heights = Query.Heights->GetData();
+        const int32 Stride = Query.MapWidth;
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            const float* Row0 = Heights + static_cast<int32>(CellYs[Lane]) * Stride + static_cast<int32>(CellXs[Lane]);
+            const float* Row1 = Row0 + Stride;
+
+            Out.H00[Lane] = Row0[0];
+            Out.H10[Lane] = Row0[1];
+            Out.H01[Lane] = Row1[0];
+            Out.H11[Lane] = Row1[1];
+        }
+    }
+
+    // Lanes past the cell diagonal lie in the (x, y+1), (x+1, y+1), (x+1, y)
+    // triangle; the others in (x, y+1), (x+1, y), (x, y)
+    FORCEINLINE VectorRegister4Float UpperTriangleMask(const VectorRegister4Float& Tx, const VectorRegister4Float& Ty)
+    {
+        return VectorCompareGT(VectorAdd(Tx, Ty), VectorOneFloat());
+    }
+
+    // Heightmap-frame Z (normalized height times HeightMultiplier) for four points
+    void LocalHeights4(const FTerrainHeightQuery& Query, const FCellLanes& Lanes, float* OutHeights)
+    {
+        const VectorRegister4Float One = VectorOneFloat();
+        const VectorRegister4Float Tx = VectorLoadAligned(Lanes.Tx);
+        const VectorRegister4Float Ty = VectorLoadAligned(Lanes.Ty);
+        const VectorRegister4Float H00 = VectorLoadAligned(Lanes.H00);
+        const VectorRegister4Float H10 = VectorLoadAligned(Lanes.H10);
+        const VectorRegister4Float H01 = VectorLoadAligned(Lanes.H01);
+        const VectorRegister4Float H11 = VectorLoadAligned(Lanes.H11);
+
+        // Each triangle is a plane through its right-angle corner
+        const VectorRegister4Float Lower = VectorMultiplyAdd(VectorSubtract(H10, H00), Tx,
+            VectorMultiplyAdd(VectorSubtract(H01, H00), Ty, H00));
+        const VectorRegister4Float Upper = VectorMultiplyAdd(VectorSubtract(H01, H11), VectorSubtract(One, Tx),
+            VectorMultiplyAdd(VectorSubtract(H10, H11), VectorSubtract(One, Ty), H11));
+
+        const VectorRegister4Float Height = VectorSelect(UpperTriangleMask(Tx, Ty), Upper, Lower);
+        VectorStoreAligned(VectorMultiply(Height, VectorSetFloat1(Query.HeightMultiplier)), OutHeights);
+    }
+
+    // Heightmap-frame face normals of the triangles under four points, as
+    // separate X/Y/Z lanes
+    void LocalNormals4(const FTerrainHeightQuery& Query, const FCellLanes& Lanes, float* OutX, float* OutY, float* OutZ)
+    {
+        const VectorRegister4Float H00 = VectorLoadAligned(Lanes.H00);
+        const VectorRegister4Float H10 = VectorLoadAligned(Lanes.H10);
+        const VectorRegister4Float H01 = VectorLoadAligned(Lanes.H01);
+        const VectorRegister4Float H11 = VectorLoadAligned(Lanes.H11);
+        const VectorRegister4Float Upper = UpperTriangleMask(VectorLoadAligned(Lanes.Tx), VectorLoadAligned(Lanes.Ty));
+
+        // World Z per world unit across one cell
+        const VectorRegister4Float SlopeScale = VectorSetFloat1(Query.HeightMultiplier / Query.GridSize);
+
+        const VectorRegister4Float DzDx = VectorMultiply(VectorSelect(Upper, VectorSubtract(H11, H01), VectorSubtract(H10, H00)), SlopeScale);
+        const VectorRegister4Float DzDy = VectorMultiply(VectorSelect(Upper, VectorSubtract(H11, H10), VectorSubtract(H01, H00)), SlopeScale);
+
+        // normalize(-DzDx, -DzDy, 1)
+        const VectorRegister4Float One = VectorOneFloat();
+        const VectorRegister4Float InvLength = VectorReciprocalSqrt(
+            VectorMultiplyAdd(DzDx, DzDx, VectorMultiplyAdd(DzDy, DzDy, One)));
+
+        VectorStoreAligned(VectorNegate(VectorMultiply(DzDx, InvLength)), OutX);
+        VectorStoreAligned(VectorNegate(VectorMultiply(DzDy, InvLength)), OutY);
+        VectorStoreAligned(InvLength, OutZ);
+    }
+}
+
+bool FTerrainHeightQuery::IsValid() const
+{
+    return Heights.IsValid()
+        && MapWidth >= 2 && MapHeight >= 2
+        && GridSize > 0.0f
+        && Heights->Num() == MapWidth * MapHeight;
+}
+
+bool FTerrainHeightQuery::Contains(const FVector2D& WorldXY) const
+{
+    const FVector Local = Transform.InverseTransformPosition(FVector(WorldXY.X, WorldXY.Y, Transform.GetLocation().Z));
+
+    return Local.X >= 0.0 && Local.X <= (MapWidth - 1) * GridSize
+        && Local.Y >= 0.0 && Local.Y <= (MapHeight - 1) * GridSize;
+}
+
+float FTerrainHeightQuery::GetHeight(const FVector2D& WorldXY) const
+{
+    float Height = 0.0f;
+    GetHeights(MakeArrayView(&WorldXY, 1), MakeArrayView(&Height, 1));
+    return Height;
+}
+
+FVector FTerrainHeightQuery::GetNormal(const FVector2D& WorldXY) const
+{
+    FVector3f Normal = FVector3f::UpVector;
+    GetNormals(MakeArrayView(&WorldXY, 1), MakeArrayView(&Normal, 1));
+    return FVector(Normal);
+}
+
+void FTerrainHeightQuery::GetHeights(TConstArrayView<FVector2D> WorldXY, TArrayView<float> OutHeights) const
+{
+    check(OutHeights.Num() >= WorldXY.Num());
+
+    if (!IsValid())
+    {
+        for (int32 i = 0; i < WorldXY.Num(); ++i)
+        {
+            OutHeights[i] = static_cast<float>(Transform.GetLocation().Z);
+        }
+        return;
+    }
+
+    FCellLanes Lanes;
+    alignas(16) float LocalZ[4];
+
+    for (int32 First = 0; First < WorldXY.Num(); First += 4)
+    {
+        const int32 NumPoints = FMath::Min(4, WorldXY.Num() - First);
+
+        GatherLanes(*this, WorldXY.GetData() + First, NumPoints, Lanes);
+        LocalHeights4(*this, Lanes, LocalZ);
+
+        for (int32 Lane = 0; Lane < NumPoints; ++Lane)
+        {
+            const FVector Local(Lanes.GridX[Lane] * GridSize, Lanes.GridY[Lane] * GridSize, LocalZ[Lane]);
+            OutHeights[First + Lane] = static_cast<float>(Transform.TransformPosition(Local).Z);
+        }
+    }
+}
+
+void FTerrainHeightQuery::GetNormals(TConstArrayView<FVector2D> WorldXY, TArrayView<FVector3f> OutNormals) const
+{
+    check(OutNormals.Num() >= WorldXY.Num());
+
+    if (!IsValid())
+    {
+        for (int32 i = 0; i < WorldXY.Num(); ++i)
+        {
+            OutNormals[i] = FVector3f::UpVector;
+        }
+        return;
+    }
+
+    FCellLanes Lanes;
+    alignas(16) float X[4];
+    alignas(16) float Y[4];
+    alignas(16) float Z[4];
+
+    // Normals take the inverse scale, then the rotation
+    const FQuat Rotation = Transform.GetRotation();
+    const FVector InvScale = Transform.GetSafeScaleReciprocal(Transform.GetScale3D());
+
+    for (int32 First = 0; First < WorldXY.Num(); First += 4)
+    {
+        const int32 NumPoints = FMath::Min(4, WorldXY.Num() - First);
+
+        GatherLanes(*this, WorldXY.GetData() + First, NumPoints, Lanes);
+        LocalNormals4(*this, Lanes, X, Y, Z);
+
+        for (int32 Lane = 0; Lane < NumPoints; ++Lane)
+        {
+            const FVector World = Rotation.RotateVector(FVector(X[Lane], Y[Lane], Z[Lane]) * InvScale);
+            OutNormals[First + Lane] = FVector3f(World.GetSafeNormal(UE_SMALL_NUMBER, FVector::UpVector));
+        }
+    }
+}
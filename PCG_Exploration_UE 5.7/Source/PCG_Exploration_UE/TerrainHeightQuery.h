@@ -0,0 +1,49 @@
+// TerrainHeightQuery.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Immutable snapshot of a committed landmass heightmap for point queries.
+// Nothing in it changes after construction and the heights are shared, so a
+// snapshot can be copied to and used from any thread while the landmass goes
+// on rebuilding; a rebuild publishes a new snapshot instead of editing this one.
+//
+// Queries interpolate linearly across the two triangles of each grid cell,
+// split along the same diagonal as the grid mesh (from (x, y+1) to (x+1, y)),
+// so they follow the regular LOD 0 surface exactly; an adaptive LOD 0 is
+// within its AdaptiveMaxError of it. Four points per SIMD step. Points off
+// the tile take the height of the nearest edge.
+//
+// World points go through Transform, so a yawed or scaled landmass answers
+// correctly. Queries are vertical in world space, which matches the surface
+// as long as the landmass is not tilted (pitch or roll).
+struct PCG_EXPLORATION_UE_API FTerrainHeightQuery
+{
+    // Normalized [0..1] heights, MapWidth x MapHeight, row-major
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> Heights;
+
+    // Heightmap frame to world: sample (x, y) with normalized height h sits at
+    // Transform.TransformPosition((x * GridSize, y * GridSize, h * HeightMultiplier))
+    FTransform Transform = FTransform::Identity;
+
+    int32 MapWidth = 0;
+    int32 MapHeight = 0;
+    float GridSize = 100.0f;
+    float HeightMultiplier = 1.0f;
+
+    bool IsValid() const;
+
+    // True when the point lies over the tile
+    bool Contains(const FVector2D& WorldXY) const;
+
+    // World Z of the surface under a world XY location
+    float GetHeight(const FVector2D& WorldXY) const;
+
+    // Unit surface normal under a world XY location
+    FVector GetNormal(const FVector2D& WorldXY) const;
+
+    // Batch forms; outputs must be at least as long as WorldXY
+    void GetHeights(TConstArrayView<FVector2D> WorldXY, TArrayView<float> OutHeights) const;
+    void GetNormals(TConstArrayView<FVector2D> WorldXY, TArrayView<FVector3f> OutNormals) const;
+};
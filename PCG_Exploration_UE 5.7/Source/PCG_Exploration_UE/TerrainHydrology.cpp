@@ -0,0 +1,551 @@
+// TerrainHydrology.cpp
+
+#include "TerrainHydrology.h"
+#include "TerrainMeshBuilder.h"
+#include "TerrainParallel.h"
+#include "TerrainStats.h"
+
+#include "Async/ParallelFor.h"
+#include "PCG_Exploration_UE.h"
+
+#include <cmath>
+
+namespace
+{
+    // D8 neighbours in a fixed order, so ties always resolve the same way
+    constexpr int32 NeighbourDX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+    constexpr int32 NeighbourDY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+    constexpr float NeighbourDistance[8] = { 1.0f, UE_SQRT_2, 1.0f, UE_SQRT_2, 1.0f, UE_SQRT_2, 1.0f, UE_SQRT_2 };
+
+    // Frontier cells handed to each task during accumulation
+    constexpr int32 WavefrontChunk = 4096;
+
+    struct FFloodCell
+    {
+        float Height;
+        int32 Index;
+    };
+
+    // Lowest first; equal heights by index so the flood order is fixed
+    struct FFloodCellLess
+    {
+        bool operator()(const FFloodCell& A, const FFloodCell& B) const
+        {
+            return A.Height < B.Height || (A.Height == B.Height && A.Index < B.Index);
+        }
+    };
+
+    struct FDrainageGrid
+    {
+        int32 Width = 0;
+        int32 Height = 0;
+        float SeaLevel01 = 0.0f;
+        const float* Heights = nullptr;
+
+        bool IsOutlet(int32 x, int32 y) const
+        {
+            return x == 0 || y == 0 || x == Width - 1 || y == Height - 1 || Heights[y * Width + x] <= SeaLevel01;
+        }
+    };
+
+    // Priority-flood+epsilon (Barnes, Lehman & Mulla 2014). Cells raised out of
+    // a depression skip the heap through the pit queue, which keeps filling
+    // large flats linear.
+    void FillDepressions(const FDrainageGrid& Grid, TArray<float>& OutFilled)
+    {
+        TERRAIN_TRACE_SCOPE("PriorityFlood");
+
+        const int32 Width = Grid.Width;
+        const int32 NumCells = Width * Grid.Height;
+
+        OutFilled.SetNumUninitialized(NumCells);
+        FMemory::Memcpy(OutFilled.GetData(), Grid.Heights, NumCells * sizeof(float));
+
+        TArray<uint8> Closed;
+        Closed.SetNumZeroed(NumCells);
+
+        TArray<FFloodCell> Open;
+        for (int32 y = 0; y < Grid.Height; ++y)
+        {
+            for (int32 x = 0; x < Width; ++x)
+            {
+                if (Grid.IsOutlet(x, y))
+                {
+                    const int32 i = y * Width + x;
+                    Closed[i] = 1;
+                    Open.Add({ OutFilled[i], i });
+                }
+            }
+        }
+        Open.Heapify(FFloodCellLess());
+
+        TArray<int32> Pit;
+        int32 PitHead = 0;
+
+        while (Open.Num() > 0 || PitHead < Pit.Num())
+        {
+            int32 Cell;
+            if (PitHead < Pit.Num())
+            {
+                Cell = Pit[PitHead++];
+            }
+            else
+            {
+                FFloodCell Top;
+                Open.HeapPop(Top, FFloodCellLess(), EAllowShrinking::No);
+                Cell = Top.Index;
+
+                Pit.Reset();
+                PitHead = 0;
+            }
+
+            const int32 x = Cell % Width;
+            const int32 y = Cell / Width;
+            const float Raised = std::nextafter(OutFilled[Cell], TNumericLimits<float>::Max());
+
+            for (int32 n = 0; n < 8; ++n)
+            {
+                const int32 nx = x + NeighbourDX[n];
+                const int32 ny = y + NeighbourDY[n];
+                if (nx < 0 || ny < 0 || nx >= Width || ny >= Grid.Height)
+                {
+                    continue;
+                }
+
+                const int32 Neighbour = ny * Width + nx;
+                if (Closed[Neighbour])
+                {
+                    continue;
+                }
+                Closed[Neighbour] = 1;
+
+                if (OutFilled[Neighbour] <= Raised)
+                {
+                    OutFilled[Neighbour] = Raised;
+                    Pit.Add(Neighbour);
+                }
+                else
+                {
+                    Open.HeapPush({ OutFilled[Neighbour], Neighbour }, FFloodCellLess());
+                }
+            }
+        }
+    }
+
+    // Groups the samples the flood raised into 8-connected basins
+    void FindLakes(const FDrainageGrid& Grid, const TArray<float>& Filled, const FTerrainHydrologySettings& H, TArray<FTerrainLake>& OutLakes)
+    {
+        TERRAIN_TRACE_SCOPE("FindLakes");
+
+        const int32 Width = Grid.Width;
+        const int32 NumCells = Width * Grid.Height;
+
+        TArray<uint8> Visited;
+        Visited.SetNumZeroed(NumCells);
+
+        TArray<int32> Basin;
+        TArray<int32> Stack;
+
+        for (int32 Seed = 0; Seed < NumCells; ++Seed)
+        {
+            if (Visited[Seed] || Filled[Seed] <= Grid.Heights[Seed])
+            {
+                continue;
+            }
+
+            // --- Flood the basin from its first sample ---
+            Basin.Reset();
+            Stack.Reset();
+            Stack.Add(Seed);
+            Visited[Seed] = 1;
+
+            float Level = 0.0f;
+            float Deepest = TNumericLimits<float>::Max();
+            FIntRect Bounds(Seed % Width, Seed / Width, Seed % Width, Seed / Width);
+
+            while (Stack.Num() > 0)
+            {
+                const int32 Cell = Stack.Pop(EAllowShrinking::No);
+                Basin.Add(Cell);
+
+                const int32 x = Cell % Width;
+                const int32 y = Cell / Width;
+                Level = FMath::Max(Level, Filled[Cell]);
+                Deepest = FMath::Min(Deepest, Grid.Heights[Cell]);
+                Bounds.Include(FIntPoint(x, y));
+
+                for (int32 n = 0; n < 8; ++n)
+                {
+                    // Raised samples are never on the border, so neighbours are on the map
+                    const int32 Neighbour = Cell + NeighbourDY[n] * Width + NeighbourDX[n];
+                    if (!Visited[Neighbour] && Filled[Neighbour] > Grid.Heights[Neighbour])
+                    {
+                        Visited[Neighbour] = 1;
+                        Stack.Add(Neighbour);
+                    }
+                }
+            }
+
+            // Flats only raised by the epsilon are not lakes
+            if (Basin.Num() < H.MinLakeCells || Level - Deepest < H.MinLakeDepth01)
+            {
+                continue;
+            }
+
+            FTerrainLake& Lake = OutLakes.AddDefaulted_GetRef();
+            Lake.Level01 = Level;
+            Lake.MaxDepth01 = Level - Deepest;
+            Lake.NumCells = Basin.Num();
+            Lake.Bounds = Bounds;
+
+            const int32 MaskWidth = Bounds.Width() + 1;
+            Lake.Mask.SetNumZeroed(MaskWidth * (Bounds.Height() + 1));
+            for (int32 Cell : Basin)
+            {
+                Lake.Mask[(Cell / Width - Bounds.Min.Y) * MaskWidth + (Cell % Width - Bounds.Min.X)] = 1;
+            }
+        }
+    }
+}
+
+bool FTerrainLake::IsSubmerged(int32 x, int32 y) const
+{
+    if (x < Bounds.Min.X || y < Bounds.Min.Y || x > Bounds.Max.X || y > Bounds.Max.Y)
+    {
+        return false;
+    }
+    return Mask[(y - Bounds.Min.Y) * (Bounds.Width() + 1) + (x - Bounds.Min.X)] != 0;
+}
+
+bool FTerrainHydrologySettings::operator==(const FTerrainHydrologySettings& Other) const
+{
+    // With no river threshold and no lake minimum nothing is traced or
+    // carved, so the remaining fields can't change the result
+    if (!IsEnabled() && !Other.IsEnabled())
+    {
+        return true;
+    }
+
+    // Depression filling is serial and flow accumulation sums integers, so
+    // bParallel and RowsPerBand can't move a river or a lake
+    return RiverThresholdCells == Other.RiverThresholdCells
+        && SeaLevel01 == Other.SeaLevel01
+        && MinLakeCells == Other.MinLakeCells
+        && MinLakeDepth01 == Other.MinLakeDepth01
+        && CarveDepth01 == Other.CarveDepth01
+        && CarveRadiusCells == Other.CarveRadiusCells
+        && BankSlope == Other.BankSlope
+        && PointSpacingCells == Other.PointSpacingCells
+        && BorderFalloffCells == Other.BorderFalloffCells;
+}
+
+void TerrainHydrology::Build(const FLandmassBuildSettings& Settings, TArray<float>& InOutHeights, FTerrainHydrologyResult& OutResult)
+{
+    const FTerrainHydrologySettings& H = Settings.Hydrology;
+    const int32 Width = Settings.MapWidth;
+    const int32 Height = Settings.MapHeight;
+    const int32 NumCells = Width * Height;
+
+    OutResult.Accumulation.Reset();
+    OutResult.Lakes.Reset();
+    OutResult.Rivers.Reset();
+
+    if (!H.IsEnabled() || Width < 3 || Height < 3 || InOutHeights.Num() != NumCells || Settings.HeightMultiplier <= 0.0f)
+    {
+        return;
+    }
+
+    TERRAIN_STAGE_SCOPE(Hydrology);
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    FDrainageGrid Grid;
+    Grid.Width = Width;
+    Grid.Height = Height;
+    Grid.SeaLevel01 = H.SeaLevel01;
+    Grid.Heights = InOutHeights.GetData();
+
+    // --- 1. Depression filling ---
+    TArray<float> Filled;
+    FillDepressions(Grid, Filled);
+
+    // Before carving, so lake levels are the terrain's own spill heights
+    if (H.MinLakeCells > 0)
+    {
+        FindLakes(Grid, Filled, H, OutResult.Lakes);
+    }
+
+    if (H.RiverThresholdCells <= 0)
+    {
+        UE_LOG(LogProceduralTerrain, Verbose, TEXT("%s: basins on %dx%d in %.2f ms (%d lakes)"),
+            *Settings.DebugName, Width, Height, (FPlatformTime::Seconds() - StartTime) * 1000.0, OutResult.Lakes.Num());
+        return;
+    }
+
+    // --- 2. D8 receivers on the filled surface ---
+    TArray<int32> Receiver;
+    Receiver.SetNumUninitialized(NumCells);
+    TerrainParallel::ForEachRowBand(Height, H.RowsPerBand, H.bParallel, TEXT("Terrain::HydrologyBand"), [&](int32 RowBegin, int32 RowEnd)
+    {
+        for (int32 y = RowBegin; y < RowEnd; ++y)
+        {
+            for (int32 x = 0; x < Width; ++x)
+            {
+                const int32 i = y * Width + x;
+                Receiver[i] = INDEX_NONE;
+                if (Grid.IsOutlet(x, y))
+                {
+                    continue;
+                }
+
+                // Filling guarantees a strictly lower neighbour; outlets sit on the border,
+                // so every neighbour of an inner cell is on the map
+                float BestDrop = 0.0f;
+                for (int32 n = 0; n < 8; ++n)
+                {
+                    const int32 Neighbour = i + NeighbourDY[n] * Width + NeighbourDX[n];
+                    const float Drop = (Filled[i] - Filled[Neighbour]) / NeighbourDistance[n];
+                    if (Drop > BestDrop)
+                    {
+                        BestDrop = Drop;
+                        Receiver[i] = Neighbour;
+                    }
+                }
+            }
+        }
+    });
+
+    // --- 3. Flow accumulation, one wavefront of ready cells at a time ---
+    TArray<int32>& Accumulation = OutResult.Accumulation;
+    Accumulation.SetNumUninitialized(NumCells);
+
+    // Donors still to arrive, counted by gathering so no task writes another's cell
+    TArray<int32> PendingDonors;
+    PendingDonors.SetNumUninitialized(NumCells);
+
+    const int32 NumBands = FMath::DivideAndRoundUp(Height, FMath::Max(H.RowsPerBand, 1));
+    TArray<TArray<int32>> BandSources;
+    BandSources.SetNum(NumBands);
+
+    TerrainParallel::ForEachRowBand(Height, H.RowsPerBand, H.bParallel, TEXT("Terrain::HydrologyBand"), [&](int32 RowBegin, int32 RowEnd)
+    {
+        TArray<int32>& Sources = BandSources[RowBegin / FMath::Max(H.RowsPerBand, 1)];
+        for (int32 y = RowBegin; y < RowEnd; ++y)
+        {
+            for (int32 x = 0; x < Width; ++x)
+            {
+                const int32 i = y * Width + x;
+                int32 NumDonors = 0;
+                for (int32 n = 0; n < 8; ++n)
+                {
+                    const int32 nx = x + NeighbourDX[n];
+                    const int32 ny = y + NeighbourDY[n];
+                    if (nx >= 0 && ny >= 0 && nx < Width && ny < Height && Receiver[ny * Width + nx] == i)
+                    {
+                        ++NumDonors;
+                    }
+                }
+
+                Accumulation[i] = 1;
+                PendingDonors[i] = NumDonors;
+                if (NumDonors == 0)
+                {
+                    Sources.Add(i);
+                }
+            }
+        }
+    });
+
+    TArray<int32> Wavefront;
+    for (TArray<int32>& Sources : BandSources)
+    {
+        Wavefront.Append(MoveTemp(Sources));
+    }
+
+    int32 NumWavefronts = 0;
+    TArray<TArray<int32>> ChunkReady;
+    while (Wavefront.Num() > 0)
+    {
+        ++NumWavefronts;
+
+        const int32 NumChunks = FMath::DivideAndRoundUp(Wavefront.Num(), WavefrontChunk);
+        ChunkReady.SetNum(NumChunks);
+
+        ParallelFor(NumChunks, [&](int32 Chunk)
+        {
+            TArray<int32>& Ready = ChunkReady[Chunk];
+            Ready.Reset();
+
+            const int32 First = Chunk * WavefrontChunk;
+            const int32 Last = FMath::Min(First + WavefrontChunk, Wavefront.Num());
+            for (int32 k = First; k < Last; ++k)
+            {
+                const int32 Cell = Wavefront[k];
+                const int32 Down = Receiver[Cell];
+                if (Down == INDEX_NONE)
+                {
+                    continue;
+                }
+
+                // Integer sums are the same in any order; the last donor in releases the receiver
+                FPlatformAtomics::InterlockedAdd(&Accumulation[Down], Accumulation[Cell]);
+                if (FPlatformAtomics::InterlockedDecrement(&PendingDonors[Down]) == 0)
+                {
+                    Ready.Add(Down);
+                }
+            }
+        }, H.bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+        Wavefront.Reset();
+        for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+        {
+            Wavefront.Append(ChunkReady[Chunk]);
+        }
+    }
+
+    // --- 4. River cells and their beds ---
+    const int32 Threshold = H.RiverThresholdCells;
+    auto IsRiver = [&](int32 i)
+    {
+        return Receiver[i] != INDEX_NONE && Accumulation[i] >= Threshold;
+    };
+
+    // Normalized rise per cell of distance from the bed
+    const float BankRise = FMath::Max(H.BankSlope, 0.0f) * Settings.GridSize / Settings.HeightMultiplier;
+    const int32 Radius = FMath::Max(H.CarveRadiusCells, 0);
+
+    TArray<float> Bed;
+    Bed.SetNumUninitialized(NumCells);
+    TArray<uint8> RiverMask;
+    RiverMask.SetNumUninitialized(NumCells);
+    TerrainParallel::ForEachRowBand(Height, H.RowsPerBand, H.bParallel, TEXT("Terrain::HydrologyBand"), [&](int32 RowBegin, int32 RowEnd)
+    {
+        for (int32 i = RowBegin * Width; i < RowEnd * Width; ++i)
+        {
+            RiverMask[i] = IsRiver(i) ? 1 : 0;
+
+            // Barely cut in at the threshold, approaching the full depth downstream
+            const float Strength = RiverMask[i] ? 1.0f - static_cast<float>(Threshold) / Accumulation[i] : 0.0f;
+            Bed[i] = FMath::Max(InOutHeights[i] - H.CarveDepth01 * Strength, 0.0f);
+        }
+    });
+
+    // --- 5. Carving: each cell lowers itself to the lowest bank of any channel in reach ---
+    if (H.CarveDepth01 > 0.0f)
+    {
+        TArray<float> Carved;
+        Carved.SetNumUninitialized(NumCells);
+        TerrainParallel::ForEachRowBand(Height, H.RowsPerBand, H.bParallel, TEXT("Terrain::HydrologyBand"), [&](int32 RowBegin, int32 RowEnd)
+        {
+            for (int32 y = RowBegin; y < RowEnd; ++y)
+            {
+                for (int32 x = 0; x < Width; ++x)
+                {
+                    const int32 i = y * Width + x;
+                    const float Original = InOutHeights[i];
+                    float Lowest = Original;
+
+                    for (int32 dy = -Radius; dy <= Radius; ++dy)
+                    {
+                        const int32 ny = y + dy;
+                        if (ny < 0 || ny >= Height)
+                        {
+                            continue;
+                        }
+                        for (int32 dx = -Radius; dx <= Radius; ++dx)
+                        {
+                            const int32 nx = x + dx;
+                            if (nx < 0 || nx >= Width || !RiverMask[ny * Width + nx])
+                            {
+                                continue;
+                            }
+
+                            const float Distance = FMath::Sqrt(static_cast<float>(dx * dx + dy * dy));
+                            if (Distance <= Radius + 0.5f)
+                            {
+                                Lowest = FMath::Min(Lowest, Bed[ny * Width + nx] + Distance * BankRise);
+                            }
+                        }
+                    }
+
+                    // Border samples are shared with the neighbouring tile, so leave them raw
+                    const int32 EdgeDistance = FMath::Min(FMath::Min(x, Width - 1 - x), FMath::Min(y, Height - 1 - y));
+                    const float Weight = FLandmassHeightApron::GetBorderWeight(EdgeDistance, H.BorderFalloffCells);
+                    Carved[i] = FMath::Lerp(Original, Lowest, Weight);
+                }
+            }
+        });
+        InOutHeights = MoveTemp(Carved);
+    }
+
+    // --- 6. Paths: from each head down to an outlet or a river already traced ---
+    TArray<uint8> Visited;
+    Visited.SetNumZeroed(NumCells);
+    const int32 Spacing = FMath::Max(H.PointSpacingCells, 1);
+
+    TArray<int32> PathCells;
+    for (int32 Head = 0; Head < NumCells; ++Head)
+    {
+        if (!RiverMask[Head])
+        {
+            continue;
+        }
+
+        // Heads have no river upstream; everything else is reached from one
+        const int32 x = Head % Width;
+        const int32 y = Head / Width;
+        bool bHasRiverDonor = false;
+        for (int32 n = 0; n < 8 && !bHasRiverDonor; ++n)
+        {
+            const int32 nx = x + NeighbourDX[n];
+            const int32 ny = y + NeighbourDY[n];
+            const int32 Neighbour = ny * Width + nx;
+            bHasRiverDonor = nx >= 0 && ny >= 0 && nx < Width && ny < Height && Receiver[Neighbour] == Head && RiverMask[Neighbour];
+        }
+        if (bHasRiverDonor)
+        {
+            continue;
+        }
+
+        PathCells.Reset();
+        int32 Cell = Head;
+        Visited[Cell] = 1;
+        PathCells.Add(Cell);
+        while (Receiver[Cell] != INDEX_NONE)
+        {
+            Cell = Receiver[Cell];
+            PathCells.Add(Cell);
+            if (Visited[Cell])
+            {
+                break;
+            }
+            Visited[Cell] = 1;
+        }
+
+        if (PathCells.Num() < 2)
+        {
+            continue;
+        }
+
+        FTerrainRiverPath& River = OutResult.Rivers.AddDefaulted_GetRef();
+        River.Flow = Accumulation[PathCells.Last()];
+        River.Points.Reserve(PathCells.Num() / Spacing + 2);
+        for (int32 k = 0; k < PathCells.Num(); ++k)
+        {
+            if (k % Spacing != 0 && k != PathCells.Num() - 1)
+            {
+                continue;
+            }
+
+            const int32 PathCell = PathCells[k];
+            River.Points.Emplace(
+                (PathCell % Width) * Settings.GridSize,
+                (PathCell / Width) * Settings.GridSize,
+                InOutHeights[PathCell] * Settings.HeightMultiplier);
+        }
+    }
+
+    UE_LOG(LogProceduralTerrain, Verbose, TEXT("%s: drainage on %dx%d in %.2f ms (%d wavefronts, %d rivers, %d lakes)"),
+        *Settings.DebugName, Width, Height, (FPlatformTime::Seconds() - StartTime) * 1000.0,
+        NumWavefronts, OutResult.Rivers.Num(), OutResult.Lakes.Num());
+}
@@ -0,0 +1,123 @@
+// TerrainHydrology.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TerrainHydrology.generated.h"
+
+struct FLandmassBuildSettings;
+
+// One river as spline points in world space, from its head to where it meets
+// the sea, the map edge or a larger river
+USTRUCT(BlueprintType)
+struct FTerrainRiver
+{
+    GENERATED_BODY()
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "River")
+    TArray<FVector> Points;
+
+    // Heightmap cells draining through the river's last point
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "River")
+    int32 Flow = 0;
+};
+
+// Parameters of the drainage analysis run on the normalized heightmap after
+// erosion. Plain data, copied into FLandmassBuildSettings.
+struct PCG_EXPLORATION_UE_API FTerrainHydrologySettings
+{
+    // Cells that must drain through a cell before it is a river; 0 traces no rivers
+    int32 RiverThresholdCells = 0;
+
+    // Cells at or below this normalized height are sea: they end every river
+    // and never hold a lake
+    float SeaLevel01 = 0.0f;
+
+    // Smallest closed depression kept as a lake, in cells; 0 finds no lakes
+    int32 MinLakeCells = 0;
+
+    // Shallower depressions (normalized, spill height minus deepest point) are dropped
+    float MinLakeDepth01 = 0.002f;
+
+    // Channel depth (normalized) for rivers much larger than the threshold;
+    // rivers just above it are barely cut in. 0 only traces them.
+    float CarveDepth01 = 0.01f;
+
+    // Banks reach this far from the channel, in cells
+    int32 CarveRadiusCells = 2;
+
+    // World-space rise per unit of distance from the channel bed to the banks
+    float BankSlope = 0.5f;
+
+    // Spacing of exported spline points along a river, in cells
+    int32 PointSpacingCells = 4;
+
+    // Carving fades to nothing over this many cells (at least 1) inside the
+    // two raw border rings; see FLandmassHeightApron::GetBorderWeight
+    int32 BorderFalloffCells = 8;
+
+    bool  bParallel = true;
+    int32 RowsPerBand = 16;
+
+    bool IsEnabled() const { return RiverThresholdCells > 0 || MinLakeCells > 0; }
+
+    bool operator==(const FTerrainHydrologySettings& Other) const;
+    bool operator!=(const FTerrainHydrologySettings& Other) const { return !(*this == Other); }
+};
+
+// One river in heightmap-local space: X/Y in world units from sample (0, 0),
+// Z = normalized height * HeightMultiplier
+struct PCG_EXPLORATION_UE_API FTerrainRiverPath
+{
+    TArray<FVector3f> Points;
+    int32 Flow = 0;
+};
+
+// One closed depression filled to the height where it spills over
+struct PCG_EXPLORATION_UE_API FTerrainLake
+{
+    // Normalized water level (the spill height)
+    float Level01 = 0.0f;
+
+    // Spill height minus the deepest heightmap sample
+    float MaxDepth01 = 0.0f;
+
+    // Heightmap samples under water, and the inclusive sample rectangle around them
+    int32 NumCells = 0;
+    FIntRect Bounds;
+
+    // 1 for submerged samples, (Bounds.Width() + 1) x (Bounds.Height() + 1), row-major
+    TArray<uint8> Mask;
+
+    bool IsSubmerged(int32 x, int32 y) const;
+};
+
+struct PCG_EXPLORATION_UE_API FTerrainHydrologyResult
+{
+    // Cells draining through each cell, itself included (MapWidth x MapHeight).
+    // Empty when no rivers were traced.
+    TArray<int32> Accumulation;
+
+    // Ordered by first sample, row-major
+    TArray<FTerrainLake> Lakes;
+
+    // Ordered by head cell, row-major
+    TArray<FTerrainRiverPath> Rivers;
+};
+
+namespace TerrainHydrology
+{
+    // Drainage over the heightmap, carving rivers into it in place:
+    //  1. Priority-flood (with epsilon) fills depressions on a copy, so every
+    //     land cell has a strictly lower neighbour on the way to an outlet.
+    //     Outlets are the map border and sea cells. Connected raised cells
+    //     are the lakes, at the filled (spill) height.
+    //  2. D8 steepest-descent directions on the filled surface, per row band.
+    //  3. Flow accumulation by parallel wavefronts from the ridge cells down;
+    //     counts are integers added atomically, so their order does not matter
+    //     and the result is deterministic.
+    //  4. Cells above the threshold are traced into paths and carved with a
+    //     gather pass, so no cell is written by two tasks.
+    // Each landmass is analysed on its own; rivers leave through its edges.
+    PCG_EXPLORATION_UE_API void Build(const FLandmassBuildSettings& Settings, TArray<float>& InOutHeights, FTerrainHydrologyResult& OutResult);
+}
@@ -0,0 +1,1264 @@
+// TerrainMeshBuilder.cpp
+
+#include "TerrainMeshBuilder.h"
+
+#include "TerrainHeightCache.h"
+#include "TerrainHeightQuery.h"
+#include "TerrainStats.h"
+
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeLock.h"
+#include "PCG_Exploration_UE.h"
+
+namespace
+{
+    // Heightmap rows/columns a level samples at the given stride. The last
+    // one is always included so every level covers the same footprint and
+    // shares its border positions with neighbouring tiles.
+    void GetLODSamples(int32 NumFull, int32 Step, TArray<int32>& OutSamples)
+    {
+        OutSamples.Reset();
+        for (int32 i = 0; i < NumFull - 1; i += Step)
+        {
+            OutSamples.Add(i);
+        }
+        OutSamples.Add(NumFull - 1);
+    }
+
+    // Largest normalized height difference between the full heightmap and the
+    // bilinear surface through the sampled rows/columns
+    float MeasureGeometricError(const TArray<float>& Heights, int32 MapWidth, int32 MapHeight,
+        const TArray<int32>& SampleXs, const TArray<int32>& SampleYs)
+    {
+        float MaxError = 0.0f;
+
+        int32 CellY = 0;
+        for (int32 y = 0; y < MapHeight; ++y)
+        {
+            while (CellY < SampleYs.Num() - 2 && SampleYs[CellY + 1] <= y)
+            {
+                ++CellY;
+            }
+
+            const int32 Y0 = SampleYs[CellY];
+            const int32 Y1 = SampleYs[CellY + 1];
+            const float Ty = static_cast<float>(y - Y0) / (Y1 - Y0);
+
+            int32 CellX = 0;
+            for (int32 x = 0; x < MapWidth; ++x)
+            {
+                while (CellX < SampleXs.Num() - 2 && SampleXs[CellX + 1] <= x)
+                {
+                    ++CellX;
+                }
+
+                const int32 X0 = SampleXs[CellX];
+                const int32 X1 = SampleXs[CellX + 1];
+                const float Tx = static_cast<float>(x - X0) / (X1 - X0);
+
+                const float Coarse = FMath::Lerp(
+                    FMath::Lerp(Heights[Y0 * MapWidth + X0], Heights[Y0 * MapWidth + X1], Tx),
+                    FMath::Lerp(Heights[Y1 * MapWidth + X0], Heights[Y1 * MapWidth + X1], Tx),
+                    Ty);
+
+                MaxError = FMath::Max(MaxError, FMath::Abs(Heights[y * MapWidth + x] - Coarse));
+            }
+        }
+
+        return MaxError;
+    }
+
+    // Border positions of a NumX x NumY grid, walked so each edge's outward
+    // side faces away from the tile: south (+X), east (+Y), north (-X), west (-Y)
+    template <typename VisitFn>
+    void WalkBorder(int32 NumX, int32 NumY, VisitFn&& Visit)
+    {
+        for (int32 x = 0; x < NumX; ++x)
+        {
+            Visit(x, 0);
+        }
+        for (int32 y = 1; y < NumY; ++y)
+        {
+            Visit(NumX - 1, y);
+        }
+        for (int32 x = NumX - 2; x >= 0; --x)
+        {
+            Visit(x, NumY - 1);
+        }
+        for (int32 y = NumY - 2; y >= 1; --y)
+        {
+            Visit(0, y);
+        }
+    }
+
+    // Border vertices of a regular grid section, in WalkBorder order
+    void GetBorderRing(int32 NumVertsX, int32 NumVertsY, TArray<int32>& OutRing)
+    {
+        OutRing.Reset(2 * (NumVertsX + NumVertsY));
+        WalkBorder(NumVertsX, NumVertsY, [&OutRing, NumVertsX](int32 x, int32 y)
+        {
+            OutRing.Add(y * NumVertsX + x);
+        });
+    }
+
+    // "No feature" in a distance transform input; large, but squares of map
+    // distances added to it stay finite
+    constexpr float DistanceTransformInfinity = 1.0e20f;
+
+    struct FDistanceTransformScratch
+    {
+        TArray<float> Line;
+        TArray<float> Boundaries;   // z: where each parabola starts to win
+        TArray<int32> Parabolas;    // v: sample each parabola is rooted at
+    };
+
+    // 1D squared Euclidean distance transform of a strided line, in place:
+    // out[q] = min over p of (q - p)^2 + in[p]. Lower envelope of parabolas,
+    // O(Num) (Felzenszwalb & Huttenlocher 2012).
+    void DistanceTransform1D(float* Data, int32 Stride, int32 Num, FDistanceTransformScratch& Scratch)
+    {
+        TArray<float>& F = Scratch.Line;
+        TArray<float>& Z = Scratch.Boundaries;
+        TArray<int32>& V = Scratch.Parabolas;
+        F.SetNumUninitialized(Num, EAllowShrinking::No);
+        Z.SetNumUninitialized(Num + 1, EAllowShrinking::No);
+        V.SetNumUninitialized(Num, EAllowShrinking::No);
+
+        bool bAnyFeature = false;
+        for (int32 q = 0; q < Num; ++q)
+        {
+            F[q] = Data[q * Stride];
+            bAnyFeature |= (F[q] < DistanceTransformInfinity);
+        }
+
+        // Nothing to measure from; the line stays at infinity
+        if (!bAnyFeature)
+        {
+            return;
+        }
+
+        int32 k = 0;
+        V[0] = 0;
+        Z[0] = -TNumericLimits<float>::Max();
+        Z[1] = TNumericLimits<float>::Max();
+
+        // Where the parabola rooted at q overtakes the one rooted at p
+        auto Intersect = [&F](int32 q, int32 p)
+        {
+            return ((F[q] + static_cast<float>(q) * q) - (F[p] + static_cast<float>(p) * p)) / (2.0f * (q - p));
+        };
+
+        for (int32 q = 1; q < Num; ++q)
+        {
+            // Z[0] is the lowest float, so this stops at the first parabola
+            float s = Intersect(q, V[k]);
+            while (s <= Z[k])
+            {
+                --k;
+                s = Intersect(q, V[k]);
+            }
+
+            ++k;
+            V[k] = q;
+            Z[k] = s;
+            Z[k + 1] = TNumericLimits<float>::Max();
+        }
+
+        k = 0;
+        for (int32 q = 0; q < Num; ++q)
+        {
+            while (Z[k + 1] < q)
+            {
+                ++k;
+            }
+            const float d = static_cast<float>(q - V[k]);
+            Data[q * Stride] = d * d + F[V[k]];
+        }
+    }
+
+    // Hangs a vertical strip below the section border. Neighbouring tiles at
+    // different levels only meet at shared corner positions, so the gaps
+    // between their edges are hidden behind these skirts. Indices for the
+    // strip come with the section's index buffer (see AppendSkirtIndices).
+    void AddSkirtVertices(FLandmassMeshSection& Section, const TArray<int32>& Ring, float SkirtDepth)
+    {
+        // Resize first; the new entries copy from earlier slots of the same arrays
+        const int32 FirstSkirtVertex = Section.Positions.Num();
+        const int32 NumWithSkirt = FirstSkirtVertex + Ring.Num();
+        Section.Positions.SetNum(NumWithSkirt);
+        Section.Normals.SetNum(NumWithSkirt);
+        Section.VertexColors.SetNum(NumWithSkirt);
+
+        for (int32 i = 0; i < Ring.Num(); ++i)
+        {
+            const int32 Top = Ring[i];
+            const int32 Bottom = FirstSkirtVertex + i;
+
+            Section.Positions[Bottom] = Section.Positions[Top] - FVector3f(0.0f, 0.0f, SkirtDepth);
+            Section.Normals[Bottom] = Section.Normals[Top];
+            Section.VertexColors[Bottom] = Section.VertexColors[Top];
+        }
+    }
+
+    void AppendGridIndices(TArray<int32>& Triangles, int32 NumVertsX, int32 NumVertsY)
+    {
+        const int32 NumQuadsX = NumVertsX - 1;
+        const int32 NumQuadsY = NumVertsY - 1;
+
+        // Sized once and written by index; this runs once per grid shape, not per build
+        const int32 First = Triangles.Num();
+        Triangles.SetNumUninitialized(First + NumQuadsX * NumQuadsY * 6);
+        int32* Out = Triangles.GetData() + First;
+
+        for (int32 y = 0; y < NumQuadsY; ++y)
+        {
+            for (int32 x = 0; x < NumQuadsX; ++x)
+            {
+                const int32 BottomLeft = y * NumVertsX + x;
+                const int32 BottomRight = BottomLeft + 1;
+                const int32 TopLeft = BottomLeft + NumVertsX;
+                const int32 TopRight = TopLeft + 1;
+
+                // First tri: TopLeft, BottomRight, BottomLeft
+                *Out++ = TopLeft;
+                *Out++ = BottomRight;
+                *Out++ = BottomLeft;
+
+                // Second tri: TopLeft, TopRight, BottomRight
+                *Out++ = TopLeft;
+                *Out++ = TopRight;
+                *Out++ = BottomRight;
+            }
+        }
+    }
+
+    // Skirt vertices follow the surface ones in ring order (see AddSkirtVertices)
+    void AppendSkirtIndices(TArray<int32>& Triangles, const TArray<int32>& Ring, int32 FirstSkirtVertex)
+    {
+        const int32 RingLength = Ring.Num();
+        Triangles.Reserve(Triangles.Num() + RingLength * 6);
+        for (int32 i = 0; i < RingLength; ++i)
+        {
+            const int32 Next = (i + 1) % RingLength;
+            const int32 Top0 = Ring[i];
+            const int32 Top1 = Ring[Next];
+            const int32 Bottom0 = FirstSkirtVertex + i;
+            const int32 Bottom1 = FirstSkirtVertex + Next;
+
+            Triangles.Add(Top0);
+            Triangles.Add(Top1);
+            Triangles.Add(Bottom0);
+
+            Triangles.Add(Top1);
+            Triangles.Add(Bottom1);
+            Triangles.Add(Bottom0);
+        }
+    }
+
+    // Positions, colours and (with central differences) normals of a
+    // section's surface vertices. SampleOf maps a vertex index to the
+    // heightmap sample it sits on.
+    template <typename SampleFn>
+    void WriteSurfaceVertices(const FLandmassBuildSettings& Settings, const TArray<float>& Heights, int32 NumVerts, SampleFn&& SampleOf,
+        const FLandmassHeightApron* Apron, const FLandmassShorelineField* Shoreline, FLandmassMeshSection& OutSection)
+    {
+        TERRAIN_STAGE_SCOPE(VertexBuild);
+
+        const int32 MapWidth = Settings.MapWidth;
+        const int32 MapHeight = Settings.MapHeight;
+        const float GridSize = Settings.GridSize;
+        const float HeightMultiplier = Settings.HeightMultiplier;
+
+        TArray<FVector3f>&     Positions = OutSection.Positions;
+        TArray<FPackedNormal>& Normals = OutSection.Normals;
+        TArray<FColor>&        VertexColors = OutSection.VertexColors;
+
+        Positions.SetNumUninitialized(NumVerts);
+        Normals.SetNumUninitialized(NumVerts);
+        VertexColors.SetNumUninitialized(NumVerts);
+
+        // UVs span [0,1] over the map
+        OutSection.UVScale = (GridSize > 0.0f)
+            ? FVector2f(1.0f / ((MapWidth - 1) * GridSize), 1.0f / ((MapHeight - 1) * GridSize))
+            : FVector2f::ZeroVector;
+
+        // Slopes and central-difference normals without a caller-provided apron
+        // fall back to one-sided differences at the border
+        FLandmassHeightApron ClampedApron;
+        if (!Apron)
+        {
+            ClampedApron.MapWidth = MapWidth;
+            ClampedApron.MapHeight = MapHeight;
+            Apron = &ClampedApron;
+        }
+
+        // World Z per normalized height step, over the two-sample span of a central difference
+        const float SlopeScale = (GridSize > 0.0f) ? HeightMultiplier / (2.0f * GridSize) : 0.0f;
+
+        const bool bHasShoreline = Shoreline && Shoreline->Encoded.Num() == MapWidth * MapHeight;
+
+        for (int32 Index = 0; Index < NumVerts; ++Index)
+        {
+            const FIntPoint Sample = SampleOf(Index);
+            const int32 MapX = Sample.X;
+            const int32 MapY = Sample.Y;
+            const int32 MapIndex = MapY * MapWidth + MapX;
+
+            const float Height01 = Heights.IsValidIndex(MapIndex) ? Heights[MapIndex] : 0.0f;
+            const float Z = Height01 * HeightMultiplier;
+            const uint8 HeightByte = static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(Height01, 0.0f, 1.0f) * 255.0f));
+
+            // Position
+            Positions[Index] = FVector3f(MapX * GridSize, MapY * GridSize, Z);
+
+            // Full-resolution neighbours at every level, so LODs shade alike
+            // and tiles agree along shared borders through the apron
+            const float Left = Apron->GetHeight(Heights, MapX - 1, MapY);
+            const float Right = Apron->GetHeight(Heights, MapX + 1, MapY);
+            const float Down = Apron->GetHeight(Heights, MapX, MapY - 1);
+            const float Up = Apron->GetHeight(Heights, MapX, MapY + 1);
+
+            const float DzDx = (Right - Left) * SlopeScale;
+            const float DzDy = (Up - Down) * SlopeScale;
+
+            // Z is 1 before normalizing, so the length is never zero
+            const FVector3f SurfaceNormal = FVector3f(-DzDx, -DzDy, 1.0f).GetUnsafeNormal();
+            const uint8 SlopeByte = static_cast<uint8>(FMath::RoundToInt((1.0f - SurfaceNormal.Z) * 255.0f));
+
+            VertexColors[Index] = FColor(
+                0,              // R - reserved (biome)
+                SlopeByte,      // G - slope, 0 flat .. 255 vertical
+                HeightByte,     // B - normalized height
+                bHasShoreline ? Shoreline->Encoded[MapIndex] : 255  // A - shoreline distance, 128 at the water line
+            );
+
+            if (Settings.bCentralDifferenceNormals)
+            {
+                Normals[Index] = FPackedNormal(SurfaceNormal);
+            }
+        }
+    }
+
+    // Vertex normals from the face normals of the first NumTris triangles
+    // (the surface; skirts come after them)
+    void AccumulateFaceNormals(FLandmassMeshSection& Section, int32 NumVerts, int32 NumTris)
+    {
+        TERRAIN_STAGE_SCOPE(Normals);
+
+        const TArray<int32>& Triangles = *Section.Triangles;
+        const TArray<FVector3f>& Positions = Section.Positions;
+
+        // Face normals are summed at full precision and packed afterwards
+        TArray<FVector3f> AccumulatedNormals;
+        AccumulatedNormals.SetNumZeroed(NumVerts);
+
+        for (int32 i = 0; i < NumTris; ++i)
+        {
+            const int32 I0 = Triangles[i * 3 + 0];
+            const int32 I1 = Triangles[i * 3 + 1];
+            const int32 I2 = Triangles[i * 3 + 2];
+
+            const FVector3f& V0 = Positions[I0];
+            const FVector3f& V1 = Positions[I1];
+            const FVector3f& V2 = Positions[I2];
+
+            const FVector3f Edge1 = V1 - V0;
+            const FVector3f Edge2 = V2 - V0;
+            const FVector3f Normal = FVector3f::CrossProduct(Edge2, Edge1).GetSafeNormal();
+
+            AccumulatedNormals[I0] += Normal;
+            AccumulatedNormals[I1] += Normal;
+            AccumulatedNormals[I2] += Normal;
+        }
+
+        for (int32 i = 0; i < NumVerts; ++i)
+        {
+            FVector3f N = AccumulatedNormals[i];
+
+            if (!N.IsNearlyZero())
+            {
+                N.Normalize();
+            }
+            else
+            {
+                N = FVector3f::UpVector;
+            }
+
+            // Extra safety against NaNs/Infs
+            if (!FMath::IsFinite(N.X) || !FMath::IsFinite(N.Y) || !FMath::IsFinite(N.Z))
+            {
+                N = FVector3f::UpVector;
+            }
+
+            Section.Normals[i] = FPackedNormal(N);
+        }
+    }
+
+    // RTIN triangles are (A, B, C) with A-B the hypotenuse and C the
+    // right-angle corner. Bisecting at the hypotenuse midpoint M gives
+    // (C, A, M) and (B, C, M). The two roots split the square along its
+    // diagonal.
+
+    // Calls Visit on every triangle Depth bisections below (A, B, C)
+    template <typename VisitFn>
+    void VisitRtinLevel(int32 Depth, int32 Ax, int32 Ay, int32 Bx, int32 By, int32 Cx, int32 Cy, VisitFn& Visit)
+    {
+        if (Depth == 0)
+        {
+            Visit(Ax, Ay, Bx, By, Cx, Cy);
+            return;
+        }
+
+        const int32 Mx = (Ax + Bx) >> 1;
+        const int32 My = (Ay + By) >> 1;
+        VisitRtinLevel(Depth - 1, Cx, Cy, Ax, Ay, Mx, My, Visit);
+        VisitRtinLevel(Depth - 1, Bx, By, Cx, Cy, Mx, My, Visit);
+    }
+
+    // Bisects from (A, B, C) while the midpoint error is above MaxError01
+    // and calls Emit on every triangle kept
+    template <typename EmitFn>
+    void ExtractRtin(const FLandmassRtinErrors& Errors, float MaxError01, int32 Ax, int32 Ay, int32 Bx, int32 By, int32 Cx, int32 Cy, EmitFn& Emit)
+    {
+        // Unit triangles have no midpoint sample to split at
+        if (FMath::Abs(Ax - Cx) + FMath::Abs(Ay - Cy) > 1)
+        {
+            const int32 Mx = (Ax + Bx) >> 1;
+            const int32 My = (Ay + By) >> 1;
+            if (Errors.Errors[My * Errors.Size + Mx] > MaxError01)
+            {
+                ExtractRtin(Errors, MaxError01, Cx, Cy, Ax, Ay, Mx, My, Emit);
+                ExtractRtin(Errors, MaxError01, Bx, By, Cx, Cy, Mx, My, Emit);
+                return;
+            }
+        }
+
+        Emit(Ax, Ay, Bx, By, Cx, Cy);
+    }
+
+    // Largest normalized height difference between the heightmap and the
+    // plane through a triangle's corners, over the samples it covers. The
+    // midpoint errors only bound this loosely (up to about 1.5x), so levels
+    // report the measured value.
+    float MeasureTriangleError(const TArray<float>& Heights, int32 RowLength, int32 Ax, int32 Ay, int32 Bx, int32 By, int32 Cx, int32 Cy)
+    {
+        const float Ha = Heights[Ay * RowLength + Ax];
+        const float Hb = Heights[By * RowLength + Bx];
+        const float Hc = Heights[Cy * RowLength + Cx];
+
+        // Twice the signed area; barycentrics are edge functions over it
+        const int32 Area2 = (Bx - Ax) * (Cy - Ay) - (By - Ay) * (Cx - Ax);
+        if (Area2 == 0)
+        {
+            return 0.0f;
+        }
+        const float InvArea2 = 1.0f / Area2;
+
+        float MaxError = 0.0f;
+        for (int32 y = FMath::Min3(Ay, By, Cy); y <= FMath::Max3(Ay, By, Cy); ++y)
+        {
+            for (int32 x = FMath::Min3(Ax, Bx, Cx); x <= FMath::Max3(Ax, Bx, Cx); ++x)
+            {
+                const int32 Wa = (Bx - x) * (Cy - y) - (By - y) * (Cx - x);
+                const int32 Wb = (Cx - x) * (Ay - y) - (Cy - y) * (Ax - x);
+                const int32 Wc = Area2 - Wa - Wb;
+
+                // Same sign as the area (or on an edge) means inside
+                if ((Area2 > 0) ? (Wa < 0 || Wb < 0 || Wc < 0) : (Wa > 0 || Wb > 0 || Wc > 0))
+                {
+                    continue;
+                }
+
+                const float Plane = (Wa * Ha + Wb * Hb + Wc * Hc) * InvArea2;
+                MaxError = FMath::Max(MaxError, FMath::Abs(Heights[y * RowLength + x] - Plane));
+            }
+        }
+
+        return MaxError;
+    }
+
+    // Index buffers handed out by GetSharedIndexBuffer. Held weakly, so a
+    // shape's buffer lives exactly as long as some section still uses it.
+    struct FIndexBufferCache
+    {
+        FCriticalSection Lock;
+        TMap<FIntVector, TWeakPtr<const TArray<int32>, ESPMode::ThreadSafe>> Buffers;
+    };
+
+    FIndexBufferCache& GetIndexBufferCache()
+    {
+        static FIndexBufferCache Cache;
+        return Cache;
+    }
+}
+
+TSharedRef<const TArray<int32>, ESPMode::ThreadSafe> TerrainMeshBuilder::GetSharedIndexBuffer(int32 NumVertsX, int32 NumVertsY, bool bWithSkirts)
+{
+    const FIntVector Key(NumVertsX, NumVertsY, bWithSkirts ? 1 : 0);
+    FIndexBufferCache& Cache = GetIndexBufferCache();
+
+    {
+        FScopeLock Lock(&Cache.Lock);
+        if (TSharedPtr<const TArray<int32>, ESPMode::ThreadSafe> Existing = Cache.Buffers.FindRef(Key).Pin())
+        {
+            return Existing.ToSharedRef();
+        }
+    }
+
+    // Built outside the lock; if two builds race on a new shape, the first
+    // one to publish wins and the other buffer is simply dropped
+    TERRAIN_STAGE_SCOPE(IndexBuild);
+
+    TSharedRef<TArray<int32>, ESPMode::ThreadSafe> Built = MakeShared<TArray<int32>, ESPMode::ThreadSafe>();
+    AppendGridIndices(*Built, NumVertsX, NumVertsY);
+    if (bWithSkirts)
+    {
+        TArray<int32> Ring;
+        GetBorderRing(NumVertsX, NumVertsY, Ring);
+        AppendSkirtIndices(*Built, Ring, NumVertsX * NumVertsY);
+    }
+
+    FScopeLock Lock(&Cache.Lock);
+    if (TSharedPtr<const TArray<int32>, ESPMode::ThreadSafe> Existing = Cache.Buffers.FindRef(Key).Pin())
+    {
+        return Existing.ToSharedRef();
+    }
+
+    // Drop entries whose buffers have already been released
+    for (auto It = Cache.Buffers.CreateIterator(); It; ++It)
+    {
+        if (!It.Value().IsValid())
+        {
+            It.RemoveCurrent();
+        }
+    }
+
+    Cache.Buffers.Add(Key, Built);
+    return Built;
+}
+
+void TerrainMeshBuilder::BuildHeightMap(const FLandmassBuildSettings& Settings, TArray<float>& OutHeights)
+{
+    const int32 NumVerts = Settings.MapWidth * Settings.MapHeight;
+    OutHeights.SetNum(NumVerts);
+
+    if (Settings.bFlatHeightMap)
+    {
+        for (int32 i = 0; i < NumVerts; ++i)
+        {
+            OutHeights[i] = 0.0f;
+        }
+        return;
+    }
+
+    TERRAIN_STAGE_SCOPE(Noise);
+
+    const double StartTime = FPlatformTime::Seconds();
+    const FTerrainNoiseSampler& Sampler = Settings.Noise;
+    float* HeightData = OutHeights.GetData();
+
+    if (Settings.bParallel)
+    {
+        // Each band owns a disjoint range of rows, so no synchronization is needed
+        const int32 BandRows = FMath::Max(Settings.RowsPerBand, 1);
+        const int32 NumRows = Settings.MapHeight;
+        const int32 NumBands = FMath::DivideAndRoundUp(NumRows, BandRows);
+
+        ParallelFor(NumBands, [&Sampler, HeightData, BandRows, NumRows](int32 Band)
+        {
+            const int32 RowBegin = Band * BandRows;
+            const int32 RowEnd = FMath::Min(RowBegin + BandRows, NumRows);
+            TERRAIN_TRACE_SCOPE("NoiseBand");
+            Sampler.BuildRows(RowBegin, RowEnd, HeightData);
+        });
+    }
+    else
+    {
+        Sampler.BuildRows(0, Settings.MapHeight, HeightData);
+    }
+
+    UE_LOG(LogProceduralTerrain, Verbose, TEXT("%s: %dx%d heightmap (%s, %s) built in %.2f ms"),
+        *Settings.DebugName, Settings.MapWidth, Settings.MapHeight,
+        Settings.bParallel ? TEXT("parallel") : TEXT("serial"),
+        Sampler.bUseVectorKernel ? TEXT("vector") : TEXT("scalar"),
+        (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void TerrainMeshBuilder::BuildSection(const FLandmassBuildSettings& Settings, const TArray<float>& Heights, int32 Step, FLandmassMeshSection& OutSection,
+    const FLandmassHeightApron* Apron, const FLandmassShorelineField* Shoreline)
+{
+    const int32 MapWidth = Settings.MapWidth;
+    const int32 MapHeight = Settings.MapHeight;
+
+    TArray<int32> SampleXs;
+    TArray<int32> SampleYs;
+    GetLODSamples(MapWidth, Step, SampleXs);
+    GetLODSamples(MapHeight, Step, SampleYs);
+
+    const int32 NumVertsX = SampleXs.Num();
+    const int32 NumVertsY = SampleYs.Num();
+    const int32 NumVerts = NumVertsX * NumVertsY;
+
+    // --- Build vertices and vertex colors (and normals, from the heightmap) ---
+    WriteSurfaceVertices(Settings, Heights, NumVerts, [&SampleXs, &SampleYs, NumVertsX](int32 Index)
+    {
+        return FIntPoint(SampleXs[Index % NumVertsX], SampleYs[Index / NumVertsX]);
+    }, Apron, Shoreline, OutSection);
+
+    // --- Triangle indices: shared by every section with this grid shape ---
+    OutSection.Triangles = GetSharedIndexBuffer(NumVertsX, NumVertsY, Settings.SkirtDepth > 0.0f);
+
+    const int32 NumTris = (NumVertsX - 1) * (NumVertsY - 1) * 2;
+    if (!Settings.bCentralDifferenceNormals)
+    {
+        AccumulateFaceNormals(OutSection, NumVerts, NumTris);
+    }
+
+    OutSection.NumSurfaceTriangles = NumTris;
+    OutSection.GeometricError = (Step > 1)
+        ? MeasureGeometricError(Heights, MapWidth, MapHeight, SampleXs, SampleYs) * Settings.HeightMultiplier
+        : 0.0f;
+
+    if (Settings.SkirtDepth > 0.0f)
+    {
+        TArray<int32> Ring;
+        GetBorderRing(NumVertsX, NumVertsY, Ring);
+        AddSkirtVertices(OutSection, Ring, Settings.SkirtDepth);
+    }
+}
+
+void TerrainMeshBuilder::BuildAdaptiveSection(const FLandmassBuildSettings& Settings, const TArray<float>& Heights, const FLandmassRtinErrors& Errors, float MaxError,
+    FLandmassMeshSection& OutSection, const FLandmassHeightApron* Apron, const FLandmassShorelineField* Shoreline)
+{
+    const int32 Size = Errors.Size;
+    const int32 Tile = Size - 1;
+    const float HeightMultiplier = Settings.HeightMultiplier;
+    const float MaxError01 = (HeightMultiplier > 0.0f) ? MaxError / HeightMultiplier : 0.0f;
+
+    // --- Select: mark the samples the kept triangles use ---
+    TArray<int32> VertexOfSample;
+    VertexOfSample.Init(INDEX_NONE, Size * Size);
+    int32 NumTris = 0;
+    float MaxLeftError01 = 0.0f;
+    {
+        TERRAIN_TRACE_SCOPE("RtinSelect");
+
+        auto Mark = [&Heights, &VertexOfSample, &NumTris, &MaxLeftError01, Size](int32 Ax, int32 Ay, int32 Bx, int32 By, int32 Cx, int32 Cy)
+        {
+            VertexOfSample[Ay * Size + Ax] = 0;
+            VertexOfSample[By * Size + Bx] = 0;
+            VertexOfSample[Cy * Size + Cx] = 0;
+            ++NumTris;
+
+            // Unit triangles cover no samples besides their corners
+            if (FMath::Abs(Ax - Cx) + FMath::Abs(Ay - Cy) > 1)
+            {
+                MaxLeftError01 = FMath::Max(MaxLeftError01, MeasureTriangleError(Heights, Size, Ax, Ay, Bx, By, Cx, Cy));
+            }
+        };
+        ExtractRtin(Errors, MaxError01, 0, 0, Tile, Tile, Tile, 0, Mark);
+        ExtractRtin(Errors, MaxError01, Tile, Tile, 0, 0, 0, Tile, Mark);
+    }
+
+    // Row-major vertex order, so neighbouring vertices stay close in memory
+    TArray<FIntPoint> Samples;
+    for (int32 y = 0; y < Size; ++y)
+    {
+        for (int32 x = 0; x < Size; ++x)
+        {
+            int32& Vertex = VertexOfSample[y * Size + x];
+            if (Vertex != INDEX_NONE)
+            {
+                Vertex = Samples.Emplace(x, y);
+            }
+        }
+    }
+    const int32 NumVerts = Samples.Num();
+
+    // --- Build vertices and vertex colors (and normals, from the heightmap) ---
+    WriteSurfaceVertices(Settings, Heights, NumVerts, [&Samples](int32 Index)
+    {
+        return Samples[Index];
+    }, Apron, Shoreline, OutSection);
+
+    // Neighbouring tiles keep different border vertices, so adaptive
+    // sections always need their skirts where there are any
+    TArray<int32> Ring;
+    if (Settings.SkirtDepth > 0.0f)
+    {
+        WalkBorder(Size, Size, [&Ring, &VertexOfSample, Size](int32 x, int32 y)
+        {
+            const int32 Vertex = VertexOfSample[y * Size + x];
+            if (Vertex != INDEX_NONE)
+            {
+                Ring.Add(Vertex);
+            }
+        });
+    }
+
+    // --- Triangle indices: this section's own, skirt strip after the surface ---
+    TSharedRef<TArray<int32>, ESPMode::ThreadSafe> Triangles = MakeShared<TArray<int32>, ESPMode::ThreadSafe>();
+    {
+        TERRAIN_STAGE_SCOPE(IndexBuild);
+
+        Triangles->Reserve(NumTris * 3 + Ring.Num() * 6);
+        TArray<int32>& Out = *Triangles;
+
+        auto Emit = [&Out, &VertexOfSample, Size](int32 Ax, int32 Ay, int32 Bx, int32 By, int32 Cx, int32 Cy)
+        {
+            // Clockwise seen from above, like the grid triangles
+            const bool bCounterClockwise = (Bx - Ax) * (Cy - Ay) - (By - Ay) * (Cx - Ax) > 0;
+            const int32 A = VertexOfSample[Ay * Size + Ax];
+            const int32 B = VertexOfSample[By * Size + Bx];
+            const int32 C = VertexOfSample[Cy * Size + Cx];
+
+            Out.Add(A);
+            Out.Add(bCounterClockwise ? C : B);
+            Out.Add(bCounterClockwise ? B : C);
+        };
+        ExtractRtin(Errors, MaxError01, 0, 0, Tile, Tile, Tile, 0, Emit);
+        ExtractRtin(Errors, MaxError01, Tile, Tile, 0, 0, 0, Tile, Emit);
+
+        if (Ring.Num() > 0)
+        {
+            AppendSkirtIndices(Out, Ring, NumVerts);
+        }
+    }
+    OutSection.Triangles = Triangles;
+
+    if (!Settings.bCentralDifferenceNormals)
+    {
+        AccumulateFaceNormals(OutSection, NumVerts, NumTris);
+    }
+
+    OutSection.NumSurfaceTriangles = NumTris;
+    OutSection.GeometricError = MaxLeftError01 * HeightMultiplier;
+
+    if (Ring.Num() > 0)
+    {
+        AddSkirtVertices(OutSection, Ring, Settings.SkirtDepth);
+    }
+}
+
+void TerrainMeshBuilder::BuildMesh(const FLandmassBuildSettings& Settings, const TArray<float>& Heights, FLandmassMeshData& OutData)
+{
+    // Stop once a level would collapse to a single quad
+    const int32 MaxLODs = 1 + FMath::FloorLog2(FMath::Max(Settings.MapWidth, Settings.MapHeight) - 1);
+    const int32 NumLODs = FMath::Clamp(Settings.NumLODs, 1, MaxLODs);
+
+    OutData.LODs.SetNum(NumLODs);
+    for (TSharedPtr<FLandmassMeshSection, ESPMode::ThreadSafe>& Section : OutData.LODs)
+    {
+        Section = MakeShared<FLandmassMeshSection, ESPMode::ThreadSafe>();
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    // One apron and shoreline field serve every level
+    FLandmassHeightApron Apron;
+    Apron.Build(Settings);
+
+    FLandmassShorelineField Shoreline;
+    Shoreline.Build(Settings, Heights);
+
+    // One error map serves every adaptive level
+    FLandmassRtinErrors RtinErrors;
+    if (Settings.AdaptiveMaxError > 0.0f)
+    {
+        RtinErrors.Build(Settings, Heights);
+        if (!RtinErrors.IsValid())
+        {
+            UE_LOG(LogProceduralTerrain, Warning, TEXT("%s: adaptive triangulation needs a square 2^k+1 heightmap, not %dx%d; building the regular grid"),
+                *Settings.DebugName, Settings.MapWidth, Settings.MapHeight);
+        }
+    }
+
+    // Levels are independent of each other
+    ParallelFor(NumLODs, [&Settings, &Heights, &OutData, &Apron, &Shoreline, &RtinErrors](int32 LOD)
+    {
+        TERRAIN_TRACE_SCOPE("Section");
+        FLandmassMeshSection& Section = *OutData.LODs[LOD];
+        if (RtinErrors.IsValid())
+        {
+            BuildAdaptiveSection(Settings, Heights, RtinErrors, Settings.AdaptiveMaxError * (1 << LOD), Section, &Apron, &Shoreline);
+        }
+        else
+        {
+            BuildSection(Settings, Heights, 1 << LOD, Section, &Apron, &Shoreline);
+        }
+        Section.Bounds = FBox3f(Section.Positions);
+    }, !Settings.bParallel);
+
+    SIZE_T SectionBytes = 0;
+    for (const TSharedPtr<FLandmassMeshSection, ESPMode::ThreadSafe>& Section : OutData.LODs)
+    {
+        SectionBytes += Section->GetAllocatedSize();
+    }
+
+    UE_LOG(LogProceduralTerrain, Verbose, TEXT("%s: %d %s mesh level(s) (%s normals) built in %.2f ms, %.1f KB of vertex data"),
+        *Settings.DebugName, NumLODs,
+        RtinErrors.IsValid() ? TEXT("adaptive") : TEXT("grid"),
+        Settings.bCentralDifferenceNormals ? TEXT("central difference") : TEXT("triangle"),
+        (FPlatformTime::Seconds() - StartTime) * 1000.0,
+        SectionBytes / 1024.0);
+}
+
+void TerrainMeshBuilder::BuildCollisionHeightField(const FLandmassBuildSettings& Settings, const TArray<float>& Heights, FLandmassCollisionHeightField& OutHeightField)
+{
+    TERRAIN_STAGE_SCOPE(Collision);
+
+    const int32 MapWidth = Settings.MapWidth;
+    const int32 MapHeight = Settings.MapHeight;
+    const int32 Step = FMath::Max(Settings.CollisionStep, 1);
+
+    // Round the cell count up and stretch the spacing to cover the full extent
+    const int32 NumX = FMath::DivideAndRoundUp(MapWidth - 1, Step) + 1;
+    const int32 NumY = FMath::DivideAndRoundUp(MapHeight - 1, Step) + 1;
+    const float MapPerSampleX = static_cast<float>(MapWidth - 1) / (NumX - 1);
+    const float MapPerSampleY = static_cast<float>(MapHeight - 1) / (NumY - 1);
+
+    OutHeightField.NumX = NumX;
+    OutHeightField.NumY = NumY;
+    OutHeightField.Spacing = FVector2f(MapPerSampleX * Settings.GridSize, MapPerSampleY * Settings.GridSize);
+    OutHeightField.Heights.SetNumUninitialized(NumX * NumY);
+
+    float MinHeight = TNumericLimits<float>::Max();
+    float MaxHeight = TNumericLimits<float>::Lowest();
+
+    for (int32 y = 0; y < NumY; ++y)
+    {
+        const float MapY = y * MapPerSampleY;
+        const int32 Y0 = FMath::Min(FMath::FloorToInt32(MapY), MapHeight - 2);
+        const float Ty = MapY - Y0;
+
+        for (int32 x = 0; x < NumX; ++x)
+        {
+            const float MapX = x * MapPerSampleX;
+            const int32 X0 = FMath::Min(FMath::FloorToInt32(MapX), MapWidth - 2);
+            const float Tx = MapX - X0;
+
+            const float* Row0 = Heights.GetData() + Y0 * MapWidth;
+            const float* Row1 = Row0 + MapWidth;
+            const float Height01 = FMath::Lerp(
+                FMath::Lerp(Row0[X0], Row0[X0 + 1], Tx),
+                FMath::Lerp(Row1[X0], Row1[X0 + 1], Tx),
+                Ty);
+
+            const float Z = Height01 * Settings.HeightMultiplier;
+            OutHeightField.Heights[y * NumX + x] = Z;
+            MinHeight = FMath::Min(MinHeight, Z);
+            MaxHeight = FMath::Max(MaxHeight, Z);
+        }
+    }
+
+    OutHeightField.MinHeight = MinHeight;
+    OutHeightField.MaxHeight = MaxHeight;
+}
+
+SIZE_T FLandmassMeshSection::GetAllocatedSize() const
+{
+    return Positions.GetAllocatedSize() + Normals.GetAllocatedSize() + VertexColors.GetAllocatedSize();
+}
+
+void FLandmassHeightApron::Build(const FLandmassBuildSettings& Settings)
+{
+    MapWidth = Settings.MapWidth;
+    MapHeight = Settings.MapHeight;
+
+    const int32 RowLength = MapWidth + 2;
+    Rows.SetNumZeroed(2 * RowLength);
+    Columns.SetNumZeroed(2 * MapHeight);
+
+    // A flat map's neighbours are flat too
+    if (Settings.bFlatHeightMap)
+    {
+        return;
+    }
+
+    const FTerrainNoiseSampler& Sampler = Settings.Noise;
+    for (int32 x = -1; x <= MapWidth; ++x)
+    {
+        Rows[x + 1] = Sampler.SampleHeight(x, -1);
+        Rows[RowLength + x + 1] = Sampler.SampleHeight(x, MapHeight);
+    }
+    for (int32 y = 0; y < MapHeight; ++y)
+    {
+        Columns[y] = Sampler.SampleHeight(-1, y);
+        Columns[MapHeight + y] = Sampler.SampleHeight(MapWidth, y);
+    }
+}
+
+void FLandmassShorelineField::Build(const FLandmassBuildSettings& Settings, const TArray<float>& Heights)
+{
+    const int32 MapWidth = Settings.MapWidth;
+    const int32 MapHeight = Settings.MapHeight;
+    const int32 NumSamples = MapWidth * MapHeight;
+
+    Encoded.Reset();
+    if (Settings.ShorelineRangeCells <= 0 || Heights.Num() != NumSamples)
+    {
+        return;
+    }
+
+    TERRAIN_TRACE_SCOPE("ShorelineField");
+
+    // Anything farther than the range encodes the same, so that much of the
+    // neighbours (plus the half-cell shoreline offset) is all the seam needs
+    const int32 Pad = Settings.ShorelineRangeCells + 1;
+    const int32 PaddedWidth = MapWidth + 2 * Pad;
+    const int32 PaddedHeight = MapHeight + 2 * Pad;
+    const int32 NumPadded = PaddedWidth * PaddedHeight;
+
+    // Squared distance to the nearest wet sample (for dry samples) and to the
+    // nearest dry one (for wet samples)
+    TArray<float> ToWater;
+    TArray<float> ToLand;
+    ToWater.SetNumUninitialized(NumPadded);
+    ToLand.SetNumUninitialized(NumPadded);
+
+    const FTerrainNoiseSampler& Sampler = Settings.Noise;
+    for (int32 py = 0; py < PaddedHeight; ++py)
+    {
+        const int32 y = py - Pad;
+        const bool bRowInside = (y >= 0 && y < MapHeight);
+
+        for (int32 px = 0; px < PaddedWidth; ++px)
+        {
+            const int32 x = px - Pad;
+
+            // Outside the map: the raw noise the neighbour starts from. A
+            // flat map's neighbours are flat too.
+            float Height01;
+            if (bRowInside && x >= 0 && x < MapWidth)
+            {
+                Height01 = Heights[y * MapWidth + x];
+            }
+            else if (Settings.bFlatHeightMap)
+            {
+                Height01 = Heights[FMath::Clamp(y, 0, MapHeight - 1) * MapWidth + FMath::Clamp(x, 0, MapWidth - 1)];
+            }
+            else
+            {
+                Height01 = Sampler.SampleHeight(x, y);
+            }
+
+            const bool bWet = Height01 <= Settings.WaterLevel01;
+            const int32 i = py * PaddedWidth + px;
+            ToWater[i] = bWet ? 0.0f : DistanceTransformInfinity;
+            ToLand[i] = bWet ? DistanceTransformInfinity : 0.0f;
+        }
+    }
+
+    const int32 BandSize = FMath::Max(Settings.RowsPerBand, 1);
+    const EParallelForFlags Flags = Settings.bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread;
+
+    for (TArray<float>* Field : { &ToWater, &ToLand })
+    {
+        float* Data = Field->GetData();
+
+        // Rows in place, then columns through a gathered line
+        ParallelFor(FMath::DivideAndRoundUp(PaddedHeight, BandSize), [Data, PaddedWidth, PaddedHeight, BandSize](int32 Band)
+        {
+            FDistanceTransformScratch Scratch;
+            for (int32 y = Band * BandSize; y < FMath::Min((Band + 1) * BandSize, PaddedHeight); ++y)
+            {
+                DistanceTransform1D(Data + y * PaddedWidth, 1, PaddedWidth, Scratch);
+            }
+        }, Flags);
+
+        ParallelFor(FMath::DivideAndRoundUp(PaddedWidth, BandSize), [Data, PaddedWidth, PaddedHeight, BandSize](int32 Band)
+        {
+            FDistanceTransformScratch Scratch;
+            for (int32 x = Band * BandSize; x < FMath::Min((Band + 1) * BandSize, PaddedWidth); ++x)
+            {
+                DistanceTransform1D(Data + x, PaddedWidth, PaddedHeight, Scratch);
+            }
+        }, Flags);
+    }
+
+    // The shoreline runs halfway between a wet and a dry sample
+    const float InvRange = 1.0f / Settings.ShorelineRangeCells;
+    Encoded.SetNumUninitialized(NumSamples);
+    for (int32 y = 0; y < MapHeight; ++y)
+    {
+        for (int32 x = 0; x < MapWidth; ++x)
+        {
+            const int32 i = (y + Pad) * PaddedWidth + (x + Pad);
+            const float Signed = (ToWater[i] > 0.0f)
+                ? FMath::Sqrt(ToWater[i]) - 0.5f
+                : 0.5f - FMath::Sqrt(ToLand[i]);
+
+            Encoded[y * MapWidth + x] = static_cast<uint8>(FMath::RoundToInt(127.5f + 127.5f * FMath::Clamp(Signed * InvRange, -1.0f, 1.0f)));
+        }
+    }
+}
+
+bool FLandmassRtinErrors::SupportsMap(int32 MapWidth, int32 MapHeight)
+{
+    return MapWidth == MapHeight && MapWidth >= 3 && FMath::IsPowerOfTwo(MapWidth - 1);
+}
+
+void FLandmassRtinErrors::Build(const FLandmassBuildSettings& Settings, const TArray<float>& Heights)
+{
+    Errors.Reset();
+    Size = 0;
+    if (!SupportsMap(Settings.MapWidth, Settings.MapHeight) || Heights.Num() != Settings.MapWidth * Settings.MapHeight)
+    {
+        return;
+    }
+
+    TERRAIN_TRACE_SCOPE("RtinErrors");
+
+    Size = Settings.MapWidth;
+    const int32 Tile = Size - 1;
+    Errors.SetNumZeroed(Size * Size);
+
+    float* ErrorData = Errors.GetData();
+    const float* HeightData = Heights.GetData();
+    const int32 RowLength = Size;
+
+    // Unit triangles sit this many bisections below the roots; the level
+    // above them is the finest with a sample at its hypotenuse midpoint
+    const int32 UnitDepth = 2 * FMath::FloorLog2(Tile);
+
+    // Finest level first, so a triangle's children are final before it reads
+    // them. Serial, since both triangles of a diamond write the same midpoint.
+    for (int32 Depth = UnitDepth - 1; Depth >= 0; --Depth)
+    {
+        const bool bHasChildren = Depth < UnitDepth - 1;
+
+        auto Update = [ErrorData, HeightData, RowLength, bHasChildren](int32 Ax, int32 Ay, int32 Bx, int32 By, int32 Cx, int32 Cy)
+        {
+            const int32 Middle = ((Ay + By) >> 1) * RowLength + ((Ax + Bx) >> 1);
+            const float Interpolated = 0.5f * (HeightData[Ay * RowLength + Ax] + HeightData[By * RowLength + Bx]);
+
+            float Error = FMath::Max(ErrorData[Middle], FMath::Abs(Interpolated - HeightData[Middle]));
+            if (bHasChildren)
+            {
+                // The children's midpoints halve the legs
+                const int32 LeftChild = ((Ay + Cy) >> 1) * RowLength + ((Ax + Cx) >> 1);
+                const int32 RightChild = ((By + Cy) >> 1) * RowLength + ((Bx + Cx) >> 1);
+                Error = FMath::Max3(Error, ErrorData[LeftChild], ErrorData[RightChild]);
+            }
+            ErrorData[Middle] = Error;
+        };
+
+        VisitRtinLevel(Depth, 0, 0, Tile, Tile, Tile, 0, Update);
+        VisitRtinLevel(Depth, Tile, Tile, 0, 0, 0, Tile, Update);
+    }
+}
+
+float FLandmassHeightApron::GetBorderWeight(int32 EdgeDistance, int32 FalloffCells)
+{
+    return FMath::SmoothStep(0.0f, 1.0f, static_cast<float>(EdgeDistance - 1) / FMath::Max(FalloffCells, 1));
+}
+
+float FLandmassHeightApron::GetHeight(const TArray<float>& Heights, int32 x, int32 y) const
+{
+    if (Rows.Num() == 0)
+    {
+        // No apron: repeat the border sample
+        x = FMath::Clamp(x, 0, MapWidth - 1);
+        y = FMath::Clamp(y, 0, MapHeight - 1);
+    }
+    else if (y < 0)
+    {
+        return Rows[x + 1];
+    }
+    else if (y >= MapHeight)
+    {
+        return Rows[MapWidth + 2 + x + 1];
+    }
+    else if (x < 0)
+    {
+        return Columns[y];
+    }
+    else if (x >= MapWidth)
+    {
+        return Columns[MapHeight + y];
+    }
+
+    return Heights[y * MapWidth + x];
+}
+
+bool FLandmassBuildSettings::ProducesSameNoise(const FLandmassBuildSettings& Other) const
+{
+    if (MapWidth != Other.MapWidth || MapHeight != Other.MapHeight || bFlatHeightMap != Other.bFlatHeightMap)
+    {
+        return false;
+    }
+
+    // A flat map ignores the sampler entirely
+    return bFlatHeightMap || Noise == Other.Noise;
+}
+
+bool FLandmassBuildSettings::ProducesSameErodedHeightMap(const FLandmassBuildSettings& Other) const
+{
+    if (!ProducesSameNoise(Other))
+    {
+        return false;
+    }
+
+    // Erosion skips a flat map
+    if (bFlatHeightMap)
+    {
+        return true;
+    }
+
+    if (Erosion != Other.Erosion)
+    {
+        return false;
+    }
+
+    // Erosion works on world-proportioned slopes
+    return !Erosion.IsEnabled() || (GridSize == Other.GridSize && HeightMultiplier == Other.HeightMultiplier);
+}
+
+bool FLandmassBuildSettings::ProducesSameHeightMap(const FLandmassBuildSettings& Other) const
+{
+    if (!ProducesSameErodedHeightMap(Other))
+    {
+        return false;
+    }
+
+    if (bFlatHeightMap)
+    {
+        return true;
+    }
+
+    if (Hydrology != Other.Hydrology)
+    {
+        return false;
+    }
+
+    // So do river banks
+    return !Hydrology.IsEnabled() || (GridSize == Other.GridSize && HeightMultiplier == Other.HeightMultiplier);
+}
+
+ELandmassBuildStage TerrainMeshBuilder::StagesFrom(ELandmassBuildStage First)
+{
+    if (First == ELandmassBuildStage::None)
+    {
+        return ELandmassBuildStage::None;
+    }
+
+    // Stages are single bits in dependency order, so everything at or above
+    // the first one's bit is downstream of it
+    const uint8 FirstBit = static_cast<uint8>(First) & (0 - static_cast<uint8>(First));
+    const uint8 Downstream = static_cast<uint8>(~(FirstBit - 1));
+    return static_cast<ELandmassBuildStage>(Downstream) & ELandmassBuildStage::All;
+}
+
+bool TerrainMeshBuilder::Build(const FLandmassBuildSettings& Settings, FLandmassMeshData& OutData, TFunctionRef<bool()> IsCancelled)
+{
+    if (Settings.MapWidth < 2 || Settings.MapHeight < 2)
+    {
+        return false;
+    }
+
+    const int32 NumVerts = Settings.MapWidth * Settings.MapHeight;
+    auto IsUsable = [NumVerts](const TSharedPtr<const TArray<float>, ESPMode::ThreadSafe>& Cached)
+    {
+        return Cached.IsValid() && Cached->Num() == NumVerts;
+    };
+
+    // Earlier stage results pass through, so the next build can resume from them too
+    OutData.NoiseHeights = IsUsable(Settings.CachedNoiseHeights) ? Settings.CachedNoiseHeights : nullptr;
+    OutData.ErodedHeights = IsUsable(Settings.CachedErodedHeights) ? Settings.CachedErodedHeights : nullptr;
+
+    if (IsUsable(Settings.CachedHeights))
+    {
+        // Noise, erosion and hydrology are still valid; everything downstream rebuilds from them
+        OutData.Heights = Settings.CachedHeights;
+        OutData.Hydrology = Settings.CachedHydrology;
+    }
+    else
+    {
+        if (!OutData.ErodedHeights.IsValid())
+        {
+            if (!OutData.NoiseHeights.IsValid())
+            {
+                TSharedRef<TArray<float>, ESPMode::ThreadSafe> Noise = MakeShared<TArray<float>, ESPMode::ThreadSafe>();
+                if (!Settings.bUseHeightCache || !TerrainHeightCache::Load(Settings, *Noise))
+                {
+                    BuildHeightMap(Settings, *Noise);
+
+                    if (Settings.bUseHeightCache && !IsCancelled())
+                    {
+                        TerrainHeightCache::Store(Settings, *Noise);
+                    }
+                }
+                OutData.NoiseHeights = Noise;
+            }
+
+            // Erodes a copy, so the noise field stays reusable
+            if (Settings.Erosion.IsEnabled() && !IsCancelled())
+            {
+                TSharedRef<TArray<float>, ESPMode::ThreadSafe> Eroded = MakeShared<TArray<float>, ESPMode::ThreadSafe>(*OutData.NoiseHeights);
+                TerrainErosion::Erode(Settings, *Eroded);
+                OutData.ErodedHeights = Eroded;
+            }
+            else
+            {
+                OutData.ErodedHeights = OutData.NoiseHeights;
+            }
+        }
+
+        // Carves another copy, for the same reason
+        if (Settings.Hydrology.IsEnabled() && !IsCancelled())
+        {
+            TSharedRef<TArray<float>, ESPMode::ThreadSafe> Carved = MakeShared<TArray<float>, ESPMode::ThreadSafe>(*OutData.ErodedHeights);
+            TSharedRef<FTerrainHydrologyResult, ESPMode::ThreadSafe> Hydrology = MakeShared<FTerrainHydrologyResult, ESPMode::ThreadSafe>();
+            TerrainHydrology::Build(Settings, *Carved, *Hydrology);
+            OutData.Heights = Carved;
+            OutData.Hydrology = Hydrology;
+        }
+        else
+        {
+            OutData.Heights = OutData.ErodedHeights;
+        }
+    }
+
+    if (IsCancelled())
+    {
+        return false;
+    }
+
+    // Heights, vertices and normals are one fused pass per section: scaling
+    // the cached heights is the vertex write itself, so splitting them would
+    // only add passes over the same memory
+    BuildMesh(Settings, *OutData.Heights, OutData);
+
+    if (Settings.CollisionStep > 0)
+    {
+        BuildCollisionHeightField(Settings, *OutData.Heights, OutData.Collision);
+    }
+
+    if (!IsCancelled())
+    {
+        OutData.Scatter = BuildScatter(Settings, OutData.Heights);
+    }
+
+    return !IsCancelled();
+}
+
+TSharedPtr<const FTerrainScatterResult, ESPMode::ThreadSafe> TerrainMeshBuilder::BuildScatter(const FLandmassBuildSettings& Settings, const TSharedPtr<const TArray<float>, ESPMode::ThreadSafe>& Heights)
+{
+    if (Settings.Scatter.Layers.Num() == 0 || !Heights.IsValid())
+    {
+        return nullptr;
+    }
+
+    // Local space: origin at sample (0, 0), Z = 0 at normalized height 0
+    FTerrainHeightQuery HeightQuery;
+    HeightQuery.Heights = Heights;
+    HeightQuery.MapWidth = Settings.MapWidth;
+    HeightQuery.MapHeight = Settings.MapHeight;
+    HeightQuery.GridSize = Settings.GridSize;
+    HeightQuery.HeightMultiplier = Settings.HeightMultiplier;
+    HeightQuery.Transform = FTransform(FVector(Settings.Scatter.WorldOrigin, 0.0));
+
+    TSharedRef<FTerrainScatterResult, ESPMode::ThreadSafe> Scatter = MakeShared<FTerrainScatterResult, ESPMode::ThreadSafe>();
+    TerrainScatter::Build(Settings.Scatter, HeightQuery, *Scatter);
+    return Scatter;
+}
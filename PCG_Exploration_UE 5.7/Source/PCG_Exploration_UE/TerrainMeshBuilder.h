@@ -0,0 +1,294 @@
+// TerrainMeshBuilder.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PackedNormal.h"
+#include "TerrainErosion.h"
+#include "TerrainHydrology.h"
+#include "TerrainNoise.h"
+#include "TerrainScatter.h"
+
+// Build pipeline stages in dependency order. Invalidating a stage invalidates
+// every stage after it (see TerrainMeshBuilder::StagesFrom).
+enum class ELandmassBuildStage : uint8
+{
+    None      = 0,
+    Noise     = 1 << 0,  // fBm sampled into the normalized heightmap
+    Erosion   = 1 << 1,  // Heightmap eroded in place (see TerrainErosion)
+    Hydrology = 1 << 2,  // Drainage analysed and rivers carved (see TerrainHydrology)
+    Heights   = 1 << 3,  // Normalized heights scaled to world Z
+    Vertices  = 1 << 4,  // Grid layout, LOD levels and skirts
+    Normals   = 1 << 5,
+    Upload    = 1 << 6,  // Sections pushed to the mesh component
+    Scatter   = 1 << 7,  // Instances placed on the heightmap and added to their components
+
+    All       = Noise | Erosion | Hydrology | Heights | Vertices | Normals | Upload | Scatter
+};
+ENUM_CLASS_FLAGS(ELandmassBuildStage)
+
+// Plain-data snapshot of everything a landmass build reads. Taken on the game
+// thread, then owned by the build so the actor can change freely meanwhile.
+struct PCG_EXPLORATION_UE_API FLandmassBuildSettings
+{
+    int32 MapWidth = 0;
+    int32 MapHeight = 0;
+    float GridSize = 100.0f;
+    float HeightMultiplier = 1.0f;
+
+    // NoiseScale <= 0 produces a flat heightmap without sampling
+    bool  bFlatHeightMap = false;
+    FTerrainNoiseSampler Noise;
+
+    // Disabled unless it has hydraulic or thermal iterations
+    FTerrainErosionSettings Erosion;
+
+    // Disabled unless RiverThresholdCells > 0
+    FTerrainHydrologySettings Hydrology;
+
+    bool  bParallel = true;
+    int32 RowsPerBand = 16;
+
+    // Normals from central differences of the heightmap in the vertex pass,
+    // instead of accumulating face normals over the triangles afterwards
+    bool  bCentralDifferenceNormals = false;
+
+    // Heightmap samples per collision heightfield cell; 0 builds no heightfield
+    int32 CollisionStep = 0;
+
+    // Look the heightmap up in TerrainHeightCache before sampling noise, and
+    // store it there after
+    bool  bUseHeightCache = false;
+
+    // Resolution levels to build; level L samples every 2^L-th heightmap vertex
+    int32 NumLODs = 1;
+
+    // Depth of the vertical skirt hung from each section's border (0 = none)
+    float SkirtDepth = 0.0f;
+
+    // Largest vertical error (world units) the full-resolution level may
+    // leave when triangulated adaptively; level L allows 2^L times as much.
+    // 0 keeps the regular grid. Needs a square heightmap of 2^k+1 samples.
+    float AdaptiveMaxError = 0.0f;
+
+    // Vertex colour A holds the signed distance to the WaterLevel01 shoreline,
+    // saturating at this many heightmap cells (0 leaves A at 255)
+    float WaterLevel01 = 0.0f;
+    int32 ShorelineRangeCells = 0;
+
+    // No layers, no scatter stage
+    FTerrainScatterSettings Scatter;
+
+    // Heightmap from an earlier build. When set, the noise, erosion and
+    // hydrology stages are skipped and the mesh is rebuilt from these heights;
+    // the caller is responsible for only passing heights that
+    // ProducesSameHeightMap says still apply.
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> CachedHeights;
+
+    // The drainage built alongside CachedHeights, passed through unchanged
+    TSharedPtr<const FTerrainHydrologyResult, ESPMode::ThreadSafe> CachedHydrology;
+
+    // Raw noise and post-erosion heightmaps from an earlier build. Without
+    // CachedHeights, the build resumes after the last of these that is set;
+    // the caller checks them with ProducesSameNoise and
+    // ProducesSameErodedHeightMap.
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> CachedNoiseHeights;
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> CachedErodedHeights;
+
+    // Owning actor name, for logs only
+    FString DebugName;
+
+    // True if both settings sample the same raw noise field
+    bool ProducesSameNoise(const FLandmassBuildSettings& Other) const;
+
+    // True if both settings also erode it the same way
+    bool ProducesSameErodedHeightMap(const FLandmassBuildSettings& Other) const;
+
+    // True if both settings produce the same normalized heightmap, i.e. only
+    // stages after Hydrology differ between them
+    bool ProducesSameHeightMap(const FLandmassBuildSettings& Other) const;
+};
+
+// One resolution level in the layout UTerrainMeshComponent renders from:
+// 20 bytes per vertex, against the ~150 of an FProcMeshVertex. UVs are the
+// position's XY times UVScale and the tangent is the grid's +X, so the render
+// proxy derives both while filling its buffers. Colours are 8-bit: R reserved
+// for biome, G slope from 0 flat to 255 vertical, B normalized height, A
+// shoreline distance.
+struct PCG_EXPLORATION_UE_API FLandmassMeshSection
+{
+    TArray<FVector3f>     Positions;
+    TArray<FPackedNormal> Normals;
+    TArray<FColor>        VertexColors;
+
+    // Maps position XY to UVs spanning [0,1] across the map
+    FVector2f UVScale = FVector2f::ZeroVector;
+
+    // Of Positions, for the component's bounds
+    FBox3f Bounds = FBox3f(ForceInit);
+
+    // Immutable and shared with every section of the same grid shape (see
+    // TerrainMeshBuilder::GetSharedIndexBuffer); adaptive sections own
+    // theirs. Two sections with the same pointer have the same topology.
+    TSharedPtr<const TArray<int32>, ESPMode::ThreadSafe> Triangles;
+
+    // Largest vertical deviation (world units) from the full-resolution surface
+    float GeometricError = 0.0f;
+
+    // Triangles excluding skirts
+    int32 NumSurfaceTriangles = 0;
+
+    // CPU bytes held by this section, excluding the shared index buffer
+    SIZE_T GetAllocatedSize() const;
+};
+
+// Heights one sample outside the map on each side, sampled from the noise so
+// central differences at the border see what the neighbouring tile sees
+struct PCG_EXPLORATION_UE_API FLandmassHeightApron
+{
+    int32 MapWidth = 0;
+    int32 MapHeight = 0;
+
+    // y = -1 then y = MapHeight, each for x in [-1, MapWidth]
+    TArray<float> Rows;
+
+    // x = -1 then x = MapWidth, each for y in [0, MapHeight)
+    TArray<float> Columns;
+
+    void Build(const FLandmassBuildSettings& Settings);
+
+    // Height at x in [-1, MapWidth], y in [-1, MapHeight]. Before Build,
+    // outside samples repeat the nearest border sample.
+    float GetHeight(const TArray<float>& Heights, int32 x, int32 y) const;
+
+    // The apron is raw noise, so erosion and river carving must leave what
+    // a neighbour's apron reads untouched: the border ring and the one
+    // inside it. Returns how much of such a change to apply EdgeDistance
+    // cells from the border; it fades in over FalloffCells (at least 1)
+    // past those two rings.
+    static float GetBorderWeight(int32 EdgeDistance, int32 FalloffCells);
+};
+
+// Signed distance from every heightmap sample to the shoreline at
+// Settings.WaterLevel01, in the vertex colour A encoding: 0 at
+// ShorelineRangeCells or more under water, 128 on the shoreline, 255 at
+// ShorelineRangeCells or more inland. Distances run across tile seams: the
+// transform covers the map plus ShorelineRangeCells + 1 samples of the
+// neighbours' raw noise on every side, and the map is cropped out of it.
+struct PCG_EXPLORATION_UE_API FLandmassShorelineField
+{
+    // MapWidth x MapHeight, row-major; empty when the settings ask for no field
+    TArray<uint8> Encoded;
+
+    // Exact Euclidean distances in linear time (Felzenszwalb & Huttenlocher),
+    // rows then columns, each spread across row/column bands
+    void Build(const FLandmassBuildSettings& Settings, const TArray<float>& Heights);
+};
+
+// Error map of the right-triangulated irregular network (RTIN) over a square
+// heightmap of 2^k+1 samples. Every triangle of the bisection hierarchy is
+// split at its hypotenuse midpoint; that sample holds the largest normalized
+// height error left by not splitting the triangle or anything below it.
+// Keeping every split above a threshold gives a crack-free mesh in the tile.
+struct PCG_EXPLORATION_UE_API FLandmassRtinErrors
+{
+    // Samples per side; 0 when the map has no RTIN hierarchy
+    int32 Size = 0;
+
+    // Size x Size, row-major
+    TArray<float> Errors;
+
+    static bool SupportsMap(int32 MapWidth, int32 MapHeight);
+
+    // Leaves the map invalid when SupportsMap is false
+    void Build(const FLandmassBuildSettings& Settings, const TArray<float>& Heights);
+
+    bool IsValid() const { return Size > 0; }
+};
+
+// Regular grid of collision heights for UTerrainHeightFieldComponent
+struct PCG_EXPLORATION_UE_API FLandmassCollisionHeightField
+{
+    // Component-space Z, NumX x NumY, row-major; sample (x, y) sits at
+    // (x, y) * Spacing. The component's world scale is applied on top.
+    TArray<float> Heights;
+    int32 NumX = 0;
+    int32 NumY = 0;
+    FVector2f Spacing = FVector2f::ZeroVector;
+
+    float MinHeight = 0.0f;
+    float MaxHeight = 0.0f;
+};
+
+// Output of the worker stage
+struct PCG_EXPLORATION_UE_API FLandmassMeshData
+{
+    // Normalized heightmap after erosion and river carving; shared with the
+    // settings' CachedHeights when those stages were skipped
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> Heights;
+
+    // The raw noise and post-erosion heightmaps behind Heights, for later
+    // builds to resume from. Disabled stages share their input's array. Null
+    // when the build started from CachedHeights without them.
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> NoiseHeights;
+    TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> ErodedHeights;
+
+    // LODs[0] is full resolution. Shared, so the mesh component keeps the
+    // built sections instead of copying them.
+    TArray<TSharedPtr<FLandmassMeshSection, ESPMode::ThreadSafe>> LODs;
+
+    // Empty unless Settings.CollisionStep > 0
+    FLandmassCollisionHeightField Collision;
+
+    // Null unless Settings.Scatter has layers; shared so the commit can
+    // hand it out over several frames
+    TSharedPtr<const FTerrainScatterResult, ESPMode::ThreadSafe> Scatter;
+
+    // Null unless Settings.Hydrology is enabled
+    TSharedPtr<const FTerrainHydrologyResult, ESPMode::ThreadSafe> Hydrology;
+};
+
+namespace TerrainMeshBuilder
+{
+    // First and every downstream stage
+    PCG_EXPLORATION_UE_API ELandmassBuildStage StagesFrom(ELandmassBuildStage First);
+
+    // Normalized [0..1] heights, MapWidth x MapHeight, row-major
+    PCG_EXPLORATION_UE_API void BuildHeightMap(const FLandmassBuildSettings& Settings, TArray<float>& OutHeights);
+
+    // Vertices, indices and normals for every LOD from an existing heightmap
+    PCG_EXPLORATION_UE_API void BuildMesh(const FLandmassBuildSettings& Settings, const TArray<float>& Heights, FLandmassMeshData& OutData);
+
+    // Grid indices for a NumVertsX x NumVertsY section, followed by the skirt
+    // strip when requested. Built once per shape and shared by every caller
+    // while any of them still holds it.
+    PCG_EXPLORATION_UE_API TSharedRef<const TArray<int32>, ESPMode::ThreadSafe> GetSharedIndexBuffer(int32 NumVertsX, int32 NumVertsY, bool bWithSkirts);
+
+    // A single level; Step is the heightmap stride (1 = full resolution).
+    // Apron is read for slopes and central-difference normals; without one
+    // the border samples use one-sided differences. Without a shoreline
+    // field, A is 255.
+    PCG_EXPLORATION_UE_API void BuildSection(const FLandmassBuildSettings& Settings, const TArray<float>& Heights, int32 Step, FLandmassMeshSection& OutSection,
+        const FLandmassHeightApron* Apron = nullptr, const FLandmassShorelineField* Shoreline = nullptr);
+
+    // A single level triangulated from an RTIN error map, splitting wherever
+    // the error is above MaxError (world units). Vertices are the samples the
+    // triangles use, row-major; the index buffer is the section's own.
+    PCG_EXPLORATION_UE_API void BuildAdaptiveSection(const FLandmassBuildSettings& Settings, const TArray<float>& Heights, const FLandmassRtinErrors& Errors, float MaxError,
+        FLandmassMeshSection& OutSection, const FLandmassHeightApron* Apron = nullptr, const FLandmassShorelineField* Shoreline = nullptr);
+
+    // Resamples the heightmap onto a grid CollisionStep times coarser that
+    // still spans the whole map, so tile edges meet exactly
+    PCG_EXPLORATION_UE_API void BuildCollisionHeightField(const FLandmassBuildSettings& Settings, const TArray<float>& Heights, FLandmassCollisionHeightField& OutHeightField);
+
+    // Instances for Settings.Scatter on a normalized heightmap; null without layers
+    PCG_EXPLORATION_UE_API TSharedPtr<const FTerrainScatterResult, ESPMode::ThreadSafe> BuildScatter(const FLandmassBuildSettings& Settings, const TSharedPtr<const TArray<float>, ESPMode::ThreadSafe>& Heights);
+
+    // Runs every stage, resuming from the latest of Settings.CachedHeights,
+    // CachedErodedHeights and CachedNoiseHeights that is set. The disk cache
+    // holds heights before erosion and carving, so their settings can change
+    // without invalidating it.
+    // Safe on any thread; IsCancelled is polled between
+    // stages and the build returns false as soon as it reports true.
+    PCG_EXPLORATION_UE_API bool Build(const FLandmassBuildSettings& Settings, FLandmassMeshData& OutData, TFunctionRef<bool()> IsCancelled);
+}
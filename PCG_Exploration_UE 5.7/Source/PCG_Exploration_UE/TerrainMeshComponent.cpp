@@ -0,0 +1,551 @@
+// TerrainMeshComponent.cpp
+
+#include "TerrainMeshComponent.h"
+#include "TerrainMeshBuilder.h"
+#include "TerrainStats.h"
+
+#include "DynamicMeshBuilder.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "LocalVertexFactory.h"
+#include "MaterialDomain.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialRenderProxy.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "PrimitiveSceneProxy.h"
+#include "PrimitiveViewRelevance.h"
+#include "SceneInterface.h"
+#include "StaticMeshResources.h"
+
+namespace
+{
+    // Expands a section into the proxy's vertex streams: tangents are the
+    // grid's +X around each normal and UVs come from the position, the two
+    // things FLandmassMeshSection leaves out. Half-precision UVs and 8-bit
+    // tangents make it 28 bytes per vertex on the GPU.
+    void FillVertexBuffers(const FLandmassMeshSection& Section, FStaticMeshVertexBuffers& OutBuffers, bool bNeedsCPUAccess)
+    {
+        const int32 NumVertices = Section.Positions.Num();
+
+        OutBuffers.PositionVertexBuffer.Init(Section.Positions, bNeedsCPUAccess);
+
+        OutBuffers.StaticMeshVertexBuffer.SetUseFullPrecisionUVs(false);
+        OutBuffers.StaticMeshVertexBuffer.SetUseHighPrecisionTangentBasis(false);
+        OutBuffers.StaticMeshVertexBuffer.Init(NumVertices, 1, bNeedsCPUAccess);
+
+        const FVector3f TangentX(1.0f, 0.0f, 0.0f);
+        for (int32 i = 0; i < NumVertices; ++i)
+        {
+            const FVector3f Normal = Section.Normals[i].ToFVector3f();
+            OutBuffers.StaticMeshVertexBuffer.SetVertexTangents(i, TangentX, Normal ^ TangentX, Normal);
+
+            const FVector3f& Position = Section.Positions[i];
+            OutBuffers.StaticMeshVertexBuffer.SetVertexUV(i, 0, FVector2f(Position.X * Section.UVScale.X, Position.Y * Section.UVScale.Y));
+        }
+
+        OutBuffers.ColorVertexBuffer.InitFromColorArray(Section.VertexColors.GetData(), NumVertices, sizeof(FColor), bNeedsCPUAccess);
+    }
+
+    void CopyToBuffer(FRHICommandListBase& RHICmdList, FRHIBuffer* Buffer, const void* Source, uint32 NumBytes)
+    {
+        if (!Buffer || NumBytes == 0)
+        {
+            return;
+        }
+
+        void* Dest = RHICmdList.LockBuffer(Buffer, 0, NumBytes, RLM_WriteOnly);
+        FMemory::Memcpy(Dest, Source, NumBytes);
+        RHICmdList.UnlockBuffer(Buffer);
+    }
+
+    class FTerrainMeshSceneProxy final : public FPrimitiveSceneProxy
+    {
+    public:
+        FTerrainMeshSceneProxy(UTerrainMeshComponent* Component, const TArray<bool>& Visible)
+            : FPrimitiveSceneProxy(Component)
+            , MaterialRelevance(Component->GetMaterialRelevance(GetScene().GetShaderPlatform()))
+        {
+            Sections.SetNum(Component->GetNumSections());
+            for (int32 Index = 0; Index < Sections.Num(); ++Index)
+            {
+                FProxySection& Section = Sections[Index];
+                Section.Source = Component->GetSection(Index);
+                Section.VertexFactory = MakeUnique<FLocalVertexFactory>(GetScene().GetFeatureLevel(), "FTerrainMeshSceneProxy");
+                Section.bVisible = Visible.IsValidIndex(Index) && Visible[Index];
+
+                Section.Material = Component->GetMaterial(Index);
+                if (!Section.Material)
+                {
+                    Section.Material = UMaterial::GetDefaultMaterial(MD_Surface);
+                }
+            }
+        }
+
+        virtual ~FTerrainMeshSceneProxy() override
+        {
+            for (FProxySection& Section : Sections)
+            {
+                Section.VertexBuffers.PositionVertexBuffer.ReleaseResource();
+                Section.VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
+                Section.VertexBuffers.ColorVertexBuffer.ReleaseResource();
+                Section.IndexBuffer.ReleaseResource();
+                Section.VertexFactory->ReleaseResource();
+            }
+        }
+
+        virtual void CreateRenderThreadResources(FRHICommandListBase& RHICmdList) override
+        {
+            for (FProxySection& Section : Sections)
+            {
+                if (!Section.Source.IsValid() || !Section.Source->Triangles.IsValid())
+                {
+                    continue;
+                }
+
+                const FLandmassMeshSection& Source = *Section.Source;
+                Section.NumVertices = Source.Positions.Num();
+                Section.NumIndices = Source.Triangles->Num();
+
+                FillVertexBuffers(Source, Section.VertexBuffers, false);
+                Section.VertexBuffers.PositionVertexBuffer.InitResource(RHICmdList);
+                Section.VertexBuffers.StaticMeshVertexBuffer.InitResource(RHICmdList);
+                Section.VertexBuffers.ColorVertexBuffer.InitResource(RHICmdList);
+
+                Section.IndexBuffer.Indices.SetNumUninitialized(Section.NumIndices);
+                FMemory::Memcpy(Section.IndexBuffer.Indices.GetData(), Source.Triangles->GetData(), Section.NumIndices * sizeof(uint32));
+                Section.IndexBuffer.InitResource(RHICmdList);
+                Section.IndexBuffer.Indices.Empty();
+
+                FLocalVertexFactory::FDataType Data;
+                Section.VertexBuffers.PositionVertexBuffer.BindPositionVertexBuffer(Section.VertexFactory.Get(), Data);
+                Section.VertexBuffers.StaticMeshVertexBuffer.BindTangentVertexBuffer(Section.VertexFactory.Get(), Data);
+                Section.VertexBuffers.StaticMeshVertexBuffer.BindPackedTexCoordVertexBuffer(Section.VertexFactory.Get(), Data);
+                Section.VertexBuffers.StaticMeshVertexBuffer.BindLightMapVertexBuffer(Section.VertexFactory.Get(), Data, 0);
+                Section.VertexBuffers.ColorVertexBuffer.BindColorVertexBuffer(Section.VertexFactory.Get(), Data);
+                Section.VertexFactory->SetData(RHICmdList, Data);
+                Section.VertexFactory->InitResource(RHICmdList);
+
+                // The GPU buffers are all the proxy keeps
+                Section.Source.Reset();
+            }
+        }
+
+        // Same vertex count as the section's current buffers; the index buffer stays
+        void UpdateSectionVertices_RenderThread(FRHICommandListBase& RHICmdList, int32 Index, const UTerrainMeshComponent::FSectionPtr& Source)
+        {
+            check(IsInRenderingThread());
+
+            if (!Sections.IsValidIndex(Index) || !Source.IsValid() || Source->Positions.Num() != Sections[Index].NumVertices)
+            {
+                return;
+            }
+
+            FStaticMeshVertexBuffers& Target = Sections[Index].VertexBuffers;
+
+            FStaticMeshVertexBuffers Staging;
+            FillVertexBuffers(*Source, Staging, true);
+
+            CopyToBuffer(RHICmdList, Target.PositionVertexBuffer.VertexBufferRHI, Staging.PositionVertexBuffer.GetVertexData(),
+                Staging.PositionVertexBuffer.GetNumVertices() * Staging.PositionVertexBuffer.GetStride());
+            CopyToBuffer(RHICmdList, Target.StaticMeshVertexBuffer.TangentsVertexBuffer.VertexBufferRHI, Staging.StaticMeshVertexBuffer.GetTangentData(),
+                Staging.StaticMeshVertexBuffer.GetTangentSize());
+            CopyToBuffer(RHICmdList, Target.StaticMeshVertexBuffer.TexCoordVertexBuffer.VertexBufferRHI, Staging.StaticMeshVertexBuffer.GetTexCoordData(),
+                Staging.StaticMeshVertexBuffer.GetTexCoordSize());
+            CopyToBuffer(RHICmdList, Target.ColorVertexBuffer.VertexBufferRHI, Staging.ColorVertexBuffer.GetVertexData(),
+                Staging.ColorVertexBuffer.GetNumVertices() * Staging.ColorVertexBuffer.GetStride());
+        }
+
+        void SetSectionVisible_RenderThread(int32 Index, bool bVisible)
+        {
+            check(IsInRenderingThread());
+
+            if (Sections.IsValidIndex(Index))
+            {
+                Sections[Index].bVisible = bVisible;
+            }
+        }
+
+        virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override
+        {
+            const bool bWireframe = AllowDebugViewmodes() && ViewFamily.EngineShowFlags.Wireframe;
+
+            FColoredMaterialRenderProxy* WireframeMaterial = nullptr;
+            if (bWireframe)
+            {
+                WireframeMaterial = new FColoredMaterialRenderProxy(
+                    GEngine->WireframeMaterial ? GEngine->WireframeMaterial->GetRenderProxy() : nullptr,
+                    FLinearColor(0.0f, 0.5f, 1.0f));
+                Collector.RegisterOneFrameMaterialProxy(WireframeMaterial);
+            }
+
+            for (const FProxySection& Section : Sections)
+            {
+                if (!Section.bVisible || Section.NumIndices == 0)
+                {
+                    continue;
+                }
+
+                const FMaterialRenderProxy* MaterialProxy = bWireframe ? WireframeMaterial : Section.Material->GetRenderProxy();
+
+                for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ++ViewIndex)
+                {
+                    if (!(VisibilityMap & (1 << ViewIndex)))
+                    {
+                        continue;
+                    }
+
+                    FMeshBatch& Mesh = Collector.AllocateMesh();
+                    Mesh.bWireframe = bWireframe;
+                    Mesh.VertexFactory = Section.VertexFactory.Get();
+                    Mesh.MaterialRenderProxy = MaterialProxy;
+                    Mesh.ReverseCulling = IsLocalToWorldDeterminantNegative();
+                    Mesh.Type = PT_TriangleList;
+                    Mesh.DepthPriorityGroup = SDPG_World;
+                    Mesh.bCanApplyViewModeOverrides = false;
+
+                    bool bHasPrecomputedVolumetricLightmap;
+                    FMatrix PreviousLocalToWorld;
+                    int32 SingleCaptureIndex;
+                    bool bOutputVelocity;
+                    GetScene().GetPrimitiveUniformShaderParameters_RenderThread(GetPrimitiveSceneInfo(), bHasPrecomputedVolumetricLightmap,
+                        PreviousLocalToWorld, SingleCaptureIndex, bOutputVelocity);
+
+                    FDynamicPrimitiveUniformBuffer& DynamicPrimitiveUniformBuffer = Collector.AllocateOneFrameResource<FDynamicPrimitiveUniformBuffer>();
+                    DynamicPrimitiveUniformBuffer.Set(Collector.GetRHICommandList(), GetLocalToWorld(), PreviousLocalToWorld, GetBounds(),
+                        GetLocalBounds(), GetLocalBounds(), true, bHasPrecomputedVolumetricLightmap, bOutputVelocity, GetCustomPrimitiveData());
+
+                    FMeshBatchElement& BatchElement = Mesh.Elements[0];
+                    BatchElement.IndexBuffer = &Section.IndexBuffer;
+                    BatchElement.PrimitiveUniformBufferResource = &DynamicPrimitiveUniformBuffer.UniformBuffer;
+                    BatchElement.PrimitiveIdMode = PrimID_DynamicPrimitiveShaderData;
+                    BatchElement.FirstIndex = 0;
+                    BatchElement.NumPrimitives = Section.NumIndices / 3;
+                    BatchElement.MinVertexIndex = 0;
+                    BatchElement.MaxVertexIndex = Section.NumVertices - 1;
+
+                    Collector.AddMesh(ViewIndex, Mesh);
+                }
+            }
+        }
+
+        virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+        {
+            FPrimitiveViewRelevance Result;
+            Result.bDrawRelevance = IsShown(View);
+            Result.bShadowRelevance = IsShadowCast(View);
+            Result.bDynamicRelevance = true;
+            Result.bRenderInMainPass = ShouldRenderInMainPass();
+            Result.bUsesLightingChannels = GetLightingChannelMask() != GetDefaultLightingChannelMask();
+            Result.bRenderCustomDepth = ShouldRenderCustomDepth();
+            Result.bTranslucentSelfShadow = bCastVolumetricTranslucentShadow;
+            MaterialRelevance.SetPrimitiveViewRelevance(Result);
+            Result.bVelocityRelevance = DrawsVelocity() && Result.bOpaque && Result.bRenderInMainPass;
+            return Result;
+        }
+
+        virtual bool CanBeOccluded() const override
+        {
+            return !MaterialRelevance.bDisableDepthTest;
+        }
+
+        virtual SIZE_T GetTypeHash() const override
+        {
+            static size_t UniquePointer;
+            return reinterpret_cast<size_t>(&UniquePointer);
+        }
+
+        virtual uint32 GetMemoryFootprint() const override
+        {
+            return sizeof(*this) + GetAllocatedSize();
+        }
+
+        SIZE_T GetAllocatedSize() const
+        {
+            return FPrimitiveSceneProxy::GetAllocatedSize() + Sections.GetAllocatedSize();
+        }
+
+    private:
+        struct FProxySection
+        {
+            // Only until CreateRenderThreadResources has filled the buffers
+            UTerrainMeshComponent::FSectionPtr Source;
+
+            FStaticMeshVertexBuffers VertexBuffers;
+            FDynamicMeshIndexBuffer32 IndexBuffer;
+            TUniquePtr<FLocalVertexFactory> VertexFactory;
+            UMaterialInterface* Material = nullptr;
+            int32 NumVertices = 0;
+            int32 NumIndices = 0;
+            bool bVisible = true;
+        };
+
+        TArray<FProxySection> Sections;
+        FMaterialRelevance MaterialRelevance;
+    };
+}
+
+UTerrainMeshComponent::UTerrainMeshComponent(const FObjectInitializer& ObjectInitializer)
+    : Super(ObjectInitializer)
+{
+    PrimaryComponentTick.bCanEverTick = false;
+
+    SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+}
+
+void UTerrainMeshComponent::SetSection(int32 Index, const FSectionPtr& Section)
+{
+    check(Index >= 0);
+
+    if (Index >= Sections.Num())
+    {
+        Sections.SetNum(Index + 1);
+        SectionVisible.SetNum(Index + 1);
+    }
+    Sections[Index] = Section;
+
+    UpdateLocalBounds();
+    MarkRenderStateDirty();
+}
+
+void UTerrainMeshComponent::UpdateSectionVertices(int32 Index, const FSectionPtr& Section)
+{
+    if (!Sections.IsValidIndex(Index) || !Sections[Index].IsValid() || !Section.IsValid()
+        || Sections[Index]->Triangles != Section->Triangles)
+    {
+        SetSection(Index, Section);
+        return;
+    }
+
+    Sections[Index] = Section;
+
+    if (SceneProxy)
+    {
+        FTerrainMeshSceneProxy* Proxy = static_cast<FTerrainMeshSceneProxy*>(SceneProxy);
+        ENQUEUE_RENDER_COMMAND(TerrainMeshUpdateSectionVertices)(
+            [Proxy, Index, Section](FRHICommandListImmediate& RHICmdList)
+            {
+                Proxy->UpdateSectionVertices_RenderThread(RHICmdList, Index, Section);
+            });
+    }
+
+    // Heights moved, so the bounds may have too
+    UpdateLocalBounds();
+    MarkRenderTransformDirty();
+}
+
+void UTerrainMeshComponent::SetNumSections(int32 Num)
+{
+    Num = FMath::Max(Num, 0);
+    if (Num == Sections.Num())
+    {
+        return;
+    }
+
+    Sections.SetNum(Num);
+    SectionVisible.SetNum(Num);
+
+    UpdateLocalBounds();
+    MarkRenderStateDirty();
+}
+
+void UTerrainMeshComponent::SetSectionVisible(int32 Index, bool bVisible)
+{
+    if (!SectionVisible.IsValidIndex(Index) || SectionVisible[Index] == bVisible)
+    {
+        return;
+    }
+
+    SectionVisible[Index] = bVisible;
+
+    if (SceneProxy)
+    {
+        FTerrainMeshSceneProxy* Proxy = static_cast<FTerrainMeshSceneProxy*>(SceneProxy);
+        ENQUEUE_RENDER_COMMAND(TerrainMeshSectionVisibility)(
+            [Proxy, Index, bVisible](FRHICommandListImmediate&)
+            {
+                Proxy->SetSectionVisible_RenderThread(Index, bVisible);
+            });
+    }
+}
+
+void UTerrainMeshComponent::SetCollisionSection(int32 Index)
+{
+    const FSectionPtr Source = GetSection(Index);
+    const int32 NewIndex = Source.IsValid() ? Index : INDEX_NONE;
+    if (NewIndex == CollisionSection && Source == CollisionSource)
+    {
+        return;
+    }
+
+    CollisionSection = NewIndex;
+    CollisionSource = Source;
+
+    if (!CollisionSource.IsValid())
+    {
+        // Drop the body and any cook still running for the old section
+        for (UBodySetup* Pending : AsyncBodySetupQueue)
+        {
+            Pending->AbortPhysicsMeshAsyncCreation();
+        }
+        AsyncBodySetupQueue.Empty();
+        BodySetup = nullptr;
+        RecreatePhysicsState();
+        return;
+    }
+
+    UpdateCollision();
+}
+
+SIZE_T UTerrainMeshComponent::GetSectionMemory() const
+{
+    SIZE_T NumBytes = 0;
+    for (const FSectionPtr& Section : Sections)
+    {
+        if (Section.IsValid())
+        {
+            NumBytes += Section->GetAllocatedSize() + (Section->Triangles.IsValid() ? Section->Triangles->GetAllocatedSize() : 0);
+        }
+    }
+    return NumBytes;
+}
+
+FPrimitiveSceneProxy* UTerrainMeshComponent::CreateSceneProxy()
+{
+    if (Sections.Num() == 0)
+    {
+        return nullptr;
+    }
+
+    return new FTerrainMeshSceneProxy(this, SectionVisible);
+}
+
+UBodySetup* UTerrainMeshComponent::GetBodySetup()
+{
+    return BodySetup;
+}
+
+int32 UTerrainMeshComponent::GetNumMaterials() const
+{
+    return Sections.Num();
+}
+
+FBoxSphereBounds UTerrainMeshComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+    if (!LocalBounds.IsValid)
+    {
+        return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.0);
+    }
+
+    return FBoxSphereBounds(LocalBounds).TransformBy(LocalToWorld);
+}
+
+void UTerrainMeshComponent::UpdateLocalBounds()
+{
+    LocalBounds = FBox(ForceInit);
+    for (const FSectionPtr& Section : Sections)
+    {
+        if (Section.IsValid() && Section->Bounds.IsValid)
+        {
+            LocalBounds += FBox(Section->Bounds);
+        }
+    }
+
+    UpdateBounds();
+}
+
+bool UTerrainMeshComponent::GetPhysicsTriMeshData(FTriMeshCollisionData* CollisionData, bool InUseAllTriData)
+{
+    if (!ContainsPhysicsTriMeshData(InUseAllTriData))
+    {
+        return false;
+    }
+
+    const FLandmassMeshSection& Section = *CollisionSource;
+    const TArray<int32>& Triangles = *Section.Triangles;
+    const int32 NumTriangles = Triangles.Num() / 3;
+
+    CollisionData->Vertices = Section.Positions;
+    CollisionData->Indices.SetNumUninitialized(NumTriangles);
+    for (int32 i = 0; i < NumTriangles; ++i)
+    {
+        FTriIndices& Triangle = CollisionData->Indices[i];
+        Triangle.v0 = Triangles[i * 3 + 0];
+        Triangle.v1 = Triangles[i * 3 + 1];
+        Triangle.v2 = Triangles[i * 3 + 2];
+    }
+    CollisionData->MaterialIndices.SetNumZeroed(NumTriangles);
+
+    // Same winding handling and cook options as UProceduralMeshComponent
+    CollisionData->bFlipNormals = true;
+    CollisionData->bDeformableMesh = true;
+    CollisionData->bFastCook = true;
+
+    return true;
+}
+
+bool UTerrainMeshComponent::ContainsPhysicsTriMeshData(bool InUseAllTriData) const
+{
+    return CollisionSource.IsValid() && CollisionSource->Triangles.IsValid() && CollisionSource->Triangles->Num() >= 3;
+}
+
+UBodySetup* UTerrainMeshComponent::CreateBodySetup()
+{
+    UBodySetup* NewBodySetup = NewObject<UBodySetup>(this, NAME_None, IsTemplate() ? RF_Public | RF_ArchetypeObject : RF_NoFlags);
+    NewBodySetup->BodySetupGuid = FGuid::NewGuid();
+    NewBodySetup->bGenerateMirroredCollision = false;
+    NewBodySetup->bDoubleSidedGeometry = true;
+    NewBodySetup->CollisionTraceFlag = CTF_UseComplexAsSimple;
+    return NewBodySetup;
+}
+
+void UTerrainMeshComponent::UpdateCollision()
+{
+    TERRAIN_STAGE_SCOPE(Collision);
+
+    UWorld* World = GetWorld();
+    const bool bAsyncCook = World && World->IsGameWorld() && bUseAsyncCooking;
+
+    if (bAsyncCook)
+    {
+        // Only the newest cook matters
+        for (UBodySetup* Pending : AsyncBodySetupQueue)
+        {
+            Pending->AbortPhysicsMeshAsyncCreation();
+        }
+
+        UBodySetup* NewBodySetup = CreateBodySetup();
+        AsyncBodySetupQueue.Add(NewBodySetup);
+        NewBodySetup->CreatePhysicsMeshesAsync(
+            FOnAsyncPhysicsCookFinished::CreateUObject(this, &UTerrainMeshComponent::FinishPhysicsAsyncCook, NewBodySetup));
+    }
+    else
+    {
+        AsyncBodySetupQueue.Empty();
+        BodySetup = CreateBodySetup();
+        BodySetup->bHasCookedCollisionData = true;
+        BodySetup->InvalidatePhysicsData();
+        BodySetup->CreatePhysicsMeshes();
+        RecreatePhysicsState();
+    }
+}
+
+void UTerrainMeshComponent::FinishPhysicsAsyncCook(bool bSuccess, UBodySetup* FinishedBodySetup)
+{
+    const int32 FoundIndex = AsyncBodySetupQueue.Find(FinishedBodySetup);
+    if (FoundIndex == INDEX_NONE)
+    {
+        return;
+    }
+
+    if (!bSuccess)
+    {
+        AsyncBodySetupQueue.RemoveAt(FoundIndex);
+        return;
+    }
+
+    // Anything queued before this cook is older than it
+    BodySetup = FinishedBodySetup;
+    AsyncBodySetupQueue.RemoveAt(0, FoundIndex + 1);
+    RecreatePhysicsState();
+}
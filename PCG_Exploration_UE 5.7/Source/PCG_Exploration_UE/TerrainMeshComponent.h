@@ -0,0 +1,88 @@
+// TerrainMeshComponent.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/MeshComponent.h"
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "TerrainMeshComponent.generated.h"
+
+struct FLandmassMeshSection;
+class UBodySetup;
+
+// Renders a landmass's LOD sections straight from the builder's compact
+// layout and cooks triangle-mesh collision from at most one of them. The
+// sections are shared with the build result rather than copied; the scene
+// proxy expands them into GPU vertex buffers on the render thread and keeps
+// no CPU copy of its own.
+UCLASS(ClassGroup = (Terrain), meta = (BlueprintSpawnableComponent))
+class PCG_EXPLORATION_UE_API UTerrainMeshComponent : public UMeshComponent, public IInterface_CollisionDataProvider
+{
+    GENERATED_BODY()
+
+public:
+    using FSectionPtr = TSharedPtr<const FLandmassMeshSection, ESPMode::ThreadSafe>;
+
+    UTerrainMeshComponent(const FObjectInitializer& ObjectInitializer);
+
+    // Cook collision off the game thread in game worlds
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Terrain")
+    bool bUseAsyncCooking = false;
+
+    // Replaces a section, adding sections up to Index if needed
+    void SetSection(int32 Index, const FSectionPtr& Section);
+
+    // Replaces a section that shares its index buffer with the one already
+    // at Index; the proxy refills its vertex buffers in place
+    void UpdateSectionVertices(int32 Index, const FSectionPtr& Section);
+
+    // Drops sections from Num on
+    void SetNumSections(int32 Num);
+
+    int32 GetNumSections() const { return Sections.Num(); }
+    FSectionPtr GetSection(int32 Index) const { return Sections.IsValidIndex(Index) ? Sections[Index] : FSectionPtr(); }
+
+    // Without recreating the render state
+    void SetSectionVisible(int32 Index, bool bVisible);
+
+    // Cooks collision from a section (INDEX_NONE for none). Recooks only when
+    // the index or that section's data changed, so call it after the sections
+    // have been set.
+    void SetCollisionSection(int32 Index);
+
+    // Bytes held by the sections; the proxy's GPU buffers are not included
+    SIZE_T GetSectionMemory() const;
+
+    virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+    virtual UBodySetup* GetBodySetup() override;
+    virtual int32 GetNumMaterials() const override;
+    virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+
+    virtual bool GetPhysicsTriMeshData(FTriMeshCollisionData* CollisionData, bool InUseAllTriData) override;
+    virtual bool ContainsPhysicsTriMeshData(bool InUseAllTriData) const override;
+    virtual bool WantsNegXTriMesh() override { return false; }
+
+private:
+    void UpdateLocalBounds();
+
+    // --- Collision cooking, as UProceduralMeshComponent does it ---
+    UBodySetup* CreateBodySetup();
+    void UpdateCollision();
+    void FinishPhysicsAsyncCook(bool bSuccess, UBodySetup* FinishedBodySetup);
+
+    TArray<FSectionPtr> Sections;
+    TArray<bool> SectionVisible;
+
+    // Section the current body was cooked from
+    int32 CollisionSection = INDEX_NONE;
+    FSectionPtr CollisionSource;
+
+    UPROPERTY(Transient)
+    UBodySetup* BodySetup = nullptr;
+
+    // Pending async cooks, oldest first
+    UPROPERTY(Transient)
+    TArray<UBodySetup*> AsyncBodySetupQueue;
+
+    FBox LocalBounds = FBox(ForceInit);
+};
@@ -0,0 +1,358 @@
+// TerrainNoise.cpp
+
+#include "TerrainNoise.h"
+
+#include "Math/VectorRegister.h"
+#include "Math/RandomStream.h"
+#include "PCG_Exploration_UE.h"
+
+namespace
+{
+    // Gradient directions of FMath's Grad2, indexed by (Hash & 7):
+    // X, X+Y, Y, -X+Y, -X, -X-Y, -Y, X-Y
+    const float GradX[8] = { 1.0f, 1.0f, 0.0f, -1.0f, -1.0f, -1.0f,  0.0f,  1.0f };
+    const float GradY[8] = { 0.0f, 1.0f, 1.0f,  1.0f,  0.0f, -1.0f, -1.0f, -1.0f };
+
+    // Per-lattice-corner gradient index (0..7), stored [Y * 256 + X].
+    //
+    // FMath keeps its permutation table private, but only (P[P[X] + Y] & 7)
+    // ever reaches the output, and that is observable: just inside a lattice
+    // corner the noise is dominated by that corner's gradient. Probing each of
+    // the 256x256 corners once recovers the exact table, so the vector kernel
+    // follows whatever FMath does without copying its data.
+    struct FPerlinGradientTable
+    {
+        uint8 Index[256 * 256];
+        bool  bValid = false;
+
+        FPerlinGradientTable()
+        {
+            Calibrate();
+        }
+
+        float Noise(float X, float Y) const
+        {
+            const float Xfl = FMath::FloorToFloat(X);
+            const float Yfl = FMath::FloorToFloat(Y);
+            const int32 Xi = static_cast<int32>(Xfl) & 255;
+            const int32 Yi = static_cast<int32>(Yfl) & 255;
+            const int32 Xi1 = (Xi + 1) & 255;
+            const int32 Yi1 = (Yi + 1) & 255;
+            const float Fx = X - Xfl;
+            const float Fy = Y - Yfl;
+            const float Fxm1 = Fx - 1.0f;
+            const float Fym1 = Fy - 1.0f;
+
+            const uint8 H00 = Index[Yi * 256 + Xi];
+            const uint8 H10 = Index[Yi * 256 + Xi1];
+            const uint8 H01 = Index[Yi1 * 256 + Xi];
+            const uint8 H11 = Index[Yi1 * 256 + Xi1];
+
+            const float U = Fx * Fx * Fx * (Fx * (Fx * 6.0f - 15.0f) + 10.0f);
+            const float V = Fy * Fy * Fy * (Fy * (Fy * 6.0f - 15.0f) + 10.0f);
+
+            return FMath::Lerp(
+                FMath::Lerp(GradX[H00] * Fx + GradY[H00] * Fy, GradX[H10] * Fxm1 + GradY[H10] * Fy, U),
+                FMath::Lerp(GradX[H01] * Fx + GradY[H01] * Fym1, GradX[H11] * Fxm1 + GradY[H11] * Fym1, U),
+                V);
+        }
+
+    private:
+        void Calibrate()
+        {
+            // At (0.01, 0.03) inside a cell the eight candidate gradients give
+            // values at least 0.01 apart, while the other three corners
+            // contribute < 1e-3 through the fade curve.
+            const float ProbeX = 0.01f;
+            const float ProbeY = 0.03f;
+
+            for (int32 Y = 0; Y < 256; ++Y)
+            {
+                for (int32 X = 0; X < 256; ++X)
+                {
+                    const float Px = static_cast<float>(X) + ProbeX;
+                    const float Py = static_cast<float>(Y) + ProbeY;
+                    const float Value = FMath::PerlinNoise2D(FVector2D(Px, Py));
+
+                    const float Fx = Px - static_cast<float>(X);
+                    const float Fy = Py - static_cast<float>(Y);
+
+                    int32 Best = 0;
+                    float BestError = TNumericLimits<float>::Max();
+                    for (int32 H = 0; H < 8; ++H)
+                    {
+                        const float Error = FMath::Abs(Value - (GradX[H] * Fx + GradY[H] * Fy));
+                        if (Error < BestError)
+                        {
+                            BestError = Error;
+                            Best = H;
+                        }
+                    }
+
+                    Index[Y * 256 + X] = static_cast<uint8>(Best);
+                }
+            }
+
+            // Cross-check against FMath at arbitrary points before trusting the table
+            FRandomStream Rng(0x7E77A1);
+            float MaxError = 0.0f;
+            for (int32 i = 0; i < 1024; ++i)
+            {
+                const float X = Rng.FRandRange(-20000.0f, 20000.0f);
+                const float Y = Rng.FRandRange(-20000.0f, 20000.0f);
+                MaxError = FMath::Max(MaxError, FMath::Abs(Noise(X, Y) - FMath::PerlinNoise2D(FVector2D(X, Y))));
+            }
+
+            bValid = MaxError <= TerrainNoise::VectorKernelTolerance;
+
+            if (!bValid)
+            {
+                UE_LOG(LogProceduralTerrain, Warning,
+                    TEXT("Vector noise kernel disabled: calibration error %g exceeds tolerance %g, using FMath::PerlinNoise2D"),
+                    MaxError, TerrainNoise::VectorKernelTolerance);
+            }
+        }
+    };
+
+    const FPerlinGradientTable& GetGradientTable()
+    {
+        static const FPerlinGradientTable Table;
+        return Table;
+    }
+
+    FORCEINLINE VectorRegister4Float Lerp4(const VectorRegister4Float& A, const VectorRegister4Float& B, const VectorRegister4Float& Alpha)
+    {
+        return VectorMultiplyAdd(Alpha, VectorSubtract(B, A), A);
+    }
+
+    FORCEINLINE VectorRegister4Float SmoothCurve4(const VectorRegister4Float& X)
+    {
+        // X^3 * (X * (X * 6 - 15) + 10)
+        const VectorRegister4Float Inner = VectorMultiplyAdd(
+            X, VectorMultiplyAdd(X, VectorSetFloat1(6.0f), VectorSetFloat1(-15.0f)), VectorSetFloat1(10.0f));
+        return VectorMultiply(VectorMultiply(VectorMultiply(X, X), X), Inner);
+    }
+
+    // Four Perlin samples at once. Hashing is a scalar gather per lane; the
+    // fade curves, gradient dot products and lerps all run in vector registers.
+    VectorRegister4Float PerlinNoise2D4(const FPerlinGradientTable& Table, const VectorRegister4Float& X, const VectorRegister4Float& Y)
+    {
+        const VectorRegister4Float Xfl = VectorFloor(X);
+        const VectorRegister4Float Yfl = VectorFloor(Y);
+
+        alignas(16) float XflLanes[4];
+        alignas(16) float YflLanes[4];
+        VectorStoreAligned(Xfl, XflLanes);
+        VectorStoreAligned(Yfl, YflLanes);
+
+        alignas(16) float G00X[4], G00Y[4], G10X[4], G10Y[4];
+        alignas(16) float G01X[4], G01Y[4], G11X[4], G11Y[4];
+
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            const int32 Xi = static_cast<int32>(XflLanes[Lane]) & 255;
+            const int32 Yi = static_cast<int32>(YflLanes[Lane]) & 255;
+            const int32 Xi1 = (Xi + 1) & 255;
+            const int32 Yi1 = (Yi + 1) & 255;
+
+            const uint8 H00 = Table.Index[Yi * 256 + Xi];
+            const uint8 H10 = Table.Index[Yi * 256 + Xi1];
+            const uint8 H01 = Table.Index[Yi1 * 256 + Xi];
+            const uint8 H11 = Table.Index[Yi1 * 256 + Xi1];
+
+            G00X[Lane] = GradX[H00]; G00Y[Lane] = GradY[H00];
+            G10X[Lane] = GradX[H10]; G10Y[Lane] = GradY[H10];
+            G01X[Lane] = GradX[H01]; G01Y[Lane] = GradY[H01];
+            G11X[Lane] = GradX[H11]; G11Y[Lane] = GradY[H11];
+        }
+
+        const VectorRegister4Float One = VectorOneFloat();
+        const VectorRegister4Float Fx = VectorSubtract(X, Xfl);
+        const VectorRegister4Float Fy = VectorSubtract(Y, Yfl);
+        const VectorRegister4Float Fxm1 = VectorSubtract(Fx, One);
+        const VectorRegister4Float Fym1 = VectorSubtract(Fy, One);
+
+        const VectorRegister4Float N00 = VectorMultiplyAdd(Fy, VectorLoadAligned(G00Y), VectorMultiply(Fx, VectorLoadAligned(G00X)));
+        const VectorRegister4Float N10 = VectorMultiplyAdd(Fy, VectorLoadAligned(G10Y), VectorMultiply(Fxm1, VectorLoadAligned(G10X)));
+        const VectorRegister4Float N01 = VectorMultiplyAdd(Fym1, VectorLoadAligned(G01Y), VectorMultiply(Fx, VectorLoadAligned(G01X)));
+        const VectorRegister4Float N11 = VectorMultiplyAdd(Fym1, VectorLoadAligned(G11Y), VectorMultiply(Fxm1, VectorLoadAligned(G11X)));
+
+        const VectorRegister4Float U = SmoothCurve4(Fx);
+        const VectorRegister4Float V = SmoothCurve4(Fy);
+
+        return Lerp4(Lerp4(N00, N10, U), Lerp4(N01, N11, U), V);
+    }
+}
+
+bool TerrainNoise::IsVectorKernelAvailable()
+{
+    return GetGradientTable().bValid;
+}
+
+void TerrainNoise::WarmUp()
+{
+    GetGradientTable();
+}
+
+bool FTerrainNoiseSampler::operator==(const FTerrainNoiseSampler& Other) const
+{
+    // Exact comparison on purpose: any change to a sample coordinate changes the output
+    return MapWidth == Other.MapWidth
+        && BaseWorldX == Other.BaseWorldX
+        && BaseWorldY == Other.BaseWorldY
+        && Offset == Other.Offset
+        && NoiseScale == Other.NoiseScale
+        && Octaves == Other.Octaves
+        && Persistence == Other.Persistence
+        && Lacunarity == Other.Lacunarity
+        && OctaveOffsets == Other.OctaveOffsets
+        && bUseVectorKernel == Other.bUseVectorKernel;
+}
+
+void FTerrainNoiseSampler::BuildRows(int32 RowBegin, int32 RowEnd, float* OutHeights) const
+{
+    if (bUseVectorKernel && TerrainNoise::IsVectorKernelAvailable())
+    {
+        BuildRowsVector(RowBegin, RowEnd, OutHeights);
+    }
+    else
+    {
+        BuildRowsScalar(RowBegin, RowEnd, OutHeights);
+    }
+}
+
+float FTerrainNoiseSampler::SampleHeight(int32 x, int32 y) const
+{
+    // World-aligned grid coordinates for this vertex
+    const float WorldGridX = BaseWorldX + static_cast<float>(x);
+    const float WorldGridY = BaseWorldY + static_cast<float>(y);
+
+    const float SampleX = (WorldGridX + Offset.X) / NoiseScale;
+    const float SampleY = (WorldGridY + Offset.Y) / NoiseScale;
+
+    float NoiseHeight = 0.0f;
+    float Amplitude = 1.0f;
+    float Frequency = 1.0f;
+    float MaxPossible = 0.0f;
+
+    for (int32 Oct = 0; Oct < Octaves; ++Oct)
+    {
+        float Px = SampleX * Frequency;
+        float Py = SampleY * Frequency;
+        if (OctaveOffsets.IsValidIndex(Oct))
+        {
+            Px += static_cast<float>(OctaveOffsets[Oct].X);
+            Py += static_cast<float>(OctaveOffsets[Oct].Y);
+        }
+
+        const float Perlin = FMath::PerlinNoise2D(FVector2D(Px, Py));
+        NoiseHeight += Perlin * Amplitude;
+
+        MaxPossible += Amplitude;
+        Amplitude *= Persistence;
+        Frequency *= Lacunarity;
+    }
+
+    if (MaxPossible > 0.0f)
+    {
+        NoiseHeight = (NoiseHeight / MaxPossible) * 0.5f + 0.5f;
+    }
+    else
+    {
+        NoiseHeight = 0.0f;
+    }
+
+    return FMath::Clamp(NoiseHeight, 0.0f, 1.0f);
+}
+
+void FTerrainNoiseSampler::BuildRowsScalar(int32 RowBegin, int32 RowEnd, float* OutHeights) const
+{
+    for (int32 y = RowBegin; y < RowEnd; ++y)
+    {
+        for (int32 x = 0; x < MapWidth; ++x)
+        {
+            OutHeights[y * MapWidth + x] = SampleHeight(x, y);
+        }
+    }
+}
+
+void FTerrainNoiseSampler::BuildRowsVector(int32 RowBegin, int32 RowEnd, float* OutHeights) const
+{
+    const FPerlinGradientTable& Table = GetGradientTable();
+
+    // The normalization term is the same for every sample
+    float MaxPossible = 0.0f;
+    {
+        float Amplitude = 1.0f;
+        for (int32 Oct = 0; Oct < Octaves; ++Oct)
+        {
+            MaxPossible += Amplitude;
+            Amplitude *= Persistence;
+        }
+    }
+
+    const VectorRegister4Float Zero = VectorZeroFloat();
+    const VectorRegister4Float One = VectorOneFloat();
+    const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+    const VectorRegister4Float MaxPossible4 = VectorSetFloat1(MaxPossible);
+
+    alignas(16) float SampleXLanes[4];
+    alignas(16) float HeightLanes[4];
+
+    for (int32 y = RowBegin; y < RowEnd; ++y)
+    {
+        const float WorldGridY = BaseWorldY + static_cast<float>(y);
+        const float SampleY = (WorldGridY + Offset.Y) / NoiseScale;
+        const VectorRegister4Float SampleY4 = VectorSetFloat1(SampleY);
+
+        for (int32 x = 0; x < MapWidth; x += 4)
+        {
+            // Sample coordinates are formed exactly as in the scalar path; the
+            // tail of a row repeats its last column and is discarded on store.
+            for (int32 Lane = 0; Lane < 4; ++Lane)
+            {
+                const int32 LaneX = FMath::Min(x + Lane, MapWidth - 1);
+                const float WorldGridX = BaseWorldX + static_cast<float>(LaneX);
+                SampleXLanes[Lane] = (WorldGridX + Offset.X) / NoiseScale;
+            }
+
+            const VectorRegister4Float SampleX4 = VectorLoadAligned(SampleXLanes);
+
+            VectorRegister4Float NoiseHeight = Zero;
+            float Amplitude = 1.0f;
+            float Frequency = 1.0f;
+
+            for (int32 Oct = 0; Oct < Octaves; ++Oct)
+            {
+                const VectorRegister4Float Frequency4 = VectorSetFloat1(Frequency);
+                VectorRegister4Float Px = VectorMultiply(SampleX4, Frequency4);
+                VectorRegister4Float Py = VectorMultiply(SampleY4, Frequency4);
+                if (OctaveOffsets.IsValidIndex(Oct))
+                {
+                    Px = VectorAdd(Px, VectorSetFloat1(static_cast<float>(OctaveOffsets[Oct].X)));
+                    Py = VectorAdd(Py, VectorSetFloat1(static_cast<float>(OctaveOffsets[Oct].Y)));
+                }
+                const VectorRegister4Float Perlin = PerlinNoise2D4(Table, Px, Py);
+
+                NoiseHeight = VectorMultiplyAdd(Perlin, VectorSetFloat1(Amplitude), NoiseHeight);
+
+                Amplitude *= Persistence;
+                Frequency *= Lacunarity;
+            }
+
+            if (MaxPossible > 0.0f)
+            {
+                NoiseHeight = VectorMultiplyAdd(VectorDivide(NoiseHeight, MaxPossible4), Half, Half);
+            }
+            else
+            {
+                NoiseHeight = Zero;
+            }
+
+            VectorStoreAligned(VectorMin(VectorMax(NoiseHeight, Zero), One), HeightLanes);
+
+            const int32 Count = FMath::Min(4, MapWidth - x);
+            FMemory::Memcpy(OutHeights + y * MapWidth + x, HeightLanes, Count * sizeof(float));
+        }
+    }
+}
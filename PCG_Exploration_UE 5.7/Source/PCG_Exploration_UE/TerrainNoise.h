@@ -0,0 +1,62 @@
+// TerrainNoise.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Everything needed to evaluate a landmass heightmap, copied out of the actor
+// so rows can be built on any thread. Each sample depends only on its own
+// coordinates, so serial and parallel builds are bit-identical.
+struct PCG_EXPLORATION_UE_API FTerrainNoiseSampler
+{
+    int32     MapWidth = 0;
+    float     BaseWorldX = 0.0f;
+    float     BaseWorldY = 0.0f;
+    FVector2D Offset = FVector2D::ZeroVector;
+    float     NoiseScale = 1.0f;
+    int32     Octaves = 0;
+    float     Persistence = 0.5f;
+    float     Lacunarity = 2.0f;
+
+    // Added to octave i's sample position after the frequency scale. Empty for
+    // world-aligned tiles; the legacy actor seeds one random offset per octave.
+    TArray<FVector2D> OctaveOffsets;
+
+    // Use the 4-wide kernel when it is available (see TerrainNoise::IsVectorKernelAvailable)
+    bool      bUseVectorKernel = true;
+
+    // Same parameters, and therefore the same samples
+    bool operator==(const FTerrainNoiseSampler& Other) const;
+    bool operator!=(const FTerrainNoiseSampler& Other) const { return !(*this == Other); }
+
+    // One normalized height through the scalar path. x/y may lie outside the
+    // map, which is how neighbouring samples past the border are found.
+    float SampleHeight(int32 x, int32 y) const;
+
+    // Fills rows [RowBegin, RowEnd) of a MapWidth-wide heightmap
+    void BuildRows(int32 RowBegin, int32 RowEnd, float* OutHeights) const;
+
+private:
+    void BuildRowsScalar(int32 RowBegin, int32 RowEnd, float* OutHeights) const;
+    void BuildRowsVector(int32 RowBegin, int32 RowEnd, float* OutHeights) const;
+};
+
+namespace TerrainNoise
+{
+    // Stamped into every TerrainHeightCache entry. Bump it whenever a change
+    // here or in BuildRows alters the heights produced for the same sampler.
+    constexpr uint32 KernelVersion = 1;
+
+    // The vector kernel reproduces FMath::PerlinNoise2D using a gradient table
+    // recovered from FMath itself on first use. Heights match the scalar path
+    // to within VectorKernelTolerance (normalized units); the difference is
+    // float rounding only (FMA contraction in the lerps and fade curve).
+    constexpr float VectorKernelTolerance = 1.0e-5f;
+
+    // False if calibration failed, in which case samplers fall back to FMath
+    PCG_EXPLORATION_UE_API bool IsVectorKernelAvailable();
+
+    // Calibrates the gradient table now. Called at module startup so the first
+    // build's worker bands don't all wait on the one that got there first.
+    PCG_EXPLORATION_UE_API void WarmUp();
+}
@@ -0,0 +1,25 @@
+// TerrainParallel.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "TerrainStats.h"
+
+namespace TerrainParallel
+{
+    // Runs Body(RowBegin, RowEnd) over disjoint bands of RowsPerBand rows, one
+    // task per band, or in order on the calling thread when !bParallel.
+    // Label names each band's event on ProceduralTerrainChannel
+    template <typename FBody>
+    void ForEachRowBand(int32 NumRows, int32 RowsPerBand, bool bParallel, const TCHAR* Label, const FBody& Body)
+    {
+        const int32 BandRows = FMath::Max(RowsPerBand, 1);
+        ParallelFor(FMath::DivideAndRoundUp(NumRows, BandRows), [&Body, BandRows, NumRows, Label](int32 Band)
+        {
+            TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(Label, ProceduralTerrainChannel);
+            const int32 RowBegin = Band * BandRows;
+            Body(RowBegin, FMath::Min(RowBegin + BandRows, NumRows));
+        }, bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+    }
+}
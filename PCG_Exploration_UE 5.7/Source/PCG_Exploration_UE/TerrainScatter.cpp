@@ -0,0 +1,218 @@
+// TerrainScatter.cpp
+
+#include "TerrainScatter.h"
+#include "TerrainHash.h"
+#include "TerrainHeightQuery.h"
+#include "TerrainStats.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    // Candidate cells are MinSpacing / sqrt(2) wide, so two candidates closer
+    // than MinSpacing are at most this many cells apart on either axis
+    constexpr int32 NeighbourCells = 2;
+
+    // Hash salts for the independent per-cell values
+    enum class ECellValue : uint32
+    {
+        OffsetX, OffsetY, Priority, Density, Yaw, Scale
+    };
+
+    uint32 HashCell(uint32 Seed, int32 CellX, int32 CellY, ECellValue Value)
+    {
+        return TerrainHash::HashCell(Seed, CellX, CellY, static_cast<uint32>(Value) + 1u);
+    }
+
+    float HashCell01(uint32 Seed, int32 CellX, int32 CellY, ECellValue Value)
+    {
+        return TerrainHash::HashCell01(Seed, CellX, CellY, static_cast<uint32>(Value) + 1u);
+    }
+
+    // World position of a cell's candidate
+    FVector2D CandidateOf(uint32 Seed, double CellSize, int32 CellX, int32 CellY)
+    {
+        return FVector2D(
+            (CellX + HashCell01(Seed, CellX, CellY, ECellValue::OffsetX)) * CellSize,
+            (CellY + HashCell01(Seed, CellX, CellY, ECellValue::OffsetY)) * CellSize);
+    }
+
+    // True if the candidate of (CellX, CellY) outranks every candidate within MinSpacing
+    bool SurvivesSpacing(uint32 Seed, double CellSize, double MinSpacing, int32 CellX, int32 CellY, const FVector2D& Point)
+    {
+        const uint32 Priority = HashCell(Seed, CellX, CellY, ECellValue::Priority);
+        const double MinSpacingSq = MinSpacing * MinSpacing;
+
+        for (int32 dy = -NeighbourCells; dy <= NeighbourCells; ++dy)
+        {
+            for (int32 dx = -NeighbourCells; dx <= NeighbourCells; ++dx)
+            {
+                if (dx == 0 && dy == 0)
+                {
+                    continue;
+                }
+
+                const int32 OtherX = CellX + dx;
+                const int32 OtherY = CellY + dy;
+                if (FVector2D::DistSquared(Point, CandidateOf(Seed, CellSize, OtherX, OtherY)) >= MinSpacingSq)
+                {
+                    continue;
+                }
+
+                // Ties (vanishingly rare) go to the lower cell, so exactly one side wins
+                const uint32 OtherPriority = HashCell(Seed, OtherX, OtherY, ECellValue::Priority);
+                if (OtherPriority > Priority || (OtherPriority == Priority && (OtherY < CellY || (OtherY == CellY && OtherX < CellX))))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    struct FBandPoints
+    {
+        TArray<FVector2D> Points;
+        TArray<FIntPoint> Cells;
+    };
+}
+
+FTerrainScatterLayerParams::FTerrainScatterLayerParams(const FTerrainScatterLayer& Layer)
+    : MinSpacing(FMath::Max(Layer.MinSpacing, 10.0f))
+    , Density(Layer.Density)
+    , HeightRange(Layer.MinHeight, Layer.MaxHeight)
+    , SlopeRange(Layer.MinSlope, Layer.MaxSlope)
+    , ScaleRange(Layer.ScaleRange.X, Layer.ScaleRange.Y)
+    , AlignToNormal(Layer.AlignToNormal)
+    , SinkDepth(Layer.SinkDepth)
+{
+}
+
+int32 FTerrainScatterResult::GetNumInstances() const
+{
+    int32 Total = 0;
+    for (const TArray<FTransform>& Layer : Instances)
+    {
+        Total += Layer.Num();
+    }
+    return Total;
+}
+
+void TerrainScatter::Build(const FTerrainScatterSettings& Settings, const FTerrainHeightQuery& HeightQuery, FTerrainScatterResult& OutResult)
+{
+    OutResult.Instances.Reset();
+    OutResult.Instances.SetNum(Settings.Layers.Num());
+
+    if (!HeightQuery.IsValid())
+    {
+        return;
+    }
+
+    TERRAIN_STAGE_SCOPE(Scatter);
+
+    // Half-open ownership: a point on the shared edge belongs to the tile after it
+    const FVector2D TileMin = Settings.WorldOrigin;
+    const FVector2D TileMax = TileMin + FVector2D(
+        (HeightQuery.MapWidth - 1) * static_cast<double>(HeightQuery.GridSize),
+        (HeightQuery.MapHeight - 1) * static_cast<double>(HeightQuery.GridSize));
+
+    const float HeightMultiplier = HeightQuery.HeightMultiplier;
+
+    for (int32 LayerIndex = 0; LayerIndex < Settings.Layers.Num(); ++LayerIndex)
+    {
+        const FTerrainScatterLayerParams& Layer = Settings.Layers[LayerIndex];
+        const uint32 Seed = HashCell(static_cast<uint32>(Settings.Seed), LayerIndex, 0, ECellValue::Priority);
+
+        const double CellSize = Layer.MinSpacing * UE_INV_SQRT_2;
+        const FIntPoint FirstCell(FMath::FloorToInt32(TileMin.X / CellSize), FMath::FloorToInt32(TileMin.Y / CellSize));
+        const FIntPoint LastCell(FMath::FloorToInt32(TileMax.X / CellSize), FMath::FloorToInt32(TileMax.Y / CellSize));
+        const int32 NumRows = LastCell.Y - FirstCell.Y + 1;
+
+        const int32 BandRows = FMath::Max(Settings.RowsPerBand, 1);
+        const int32 NumBands = FMath::DivideAndRoundUp(NumRows, BandRows);
+
+        TArray<TArray<FTransform>> BandInstances;
+        BandInstances.SetNum(NumBands);
+
+        ParallelFor(NumBands, [&](int32 Band)
+        {
+            TERRAIN_TRACE_SCOPE("ScatterBand");
+
+            // --- Spacing: pure function of world cells, shared by every tile ---
+            FBandPoints Candidates;
+            const int32 RowBegin = FirstCell.Y + Band * BandRows;
+            const int32 RowEnd = FMath::Min(RowBegin + BandRows, LastCell.Y + 1);
+
+            for (int32 CellY = RowBegin; CellY < RowEnd; ++CellY)
+            {
+                for (int32 CellX = FirstCell.X; CellX <= LastCell.X; ++CellX)
+                {
+                    const FVector2D Point = CandidateOf(Seed, CellSize, CellX, CellY);
+                    if (Point.X < TileMin.X || Point.X >= TileMax.X || Point.Y < TileMin.Y || Point.Y >= TileMax.Y)
+                    {
+                        continue;
+                    }
+
+                    if (HashCell01(Seed, CellX, CellY, ECellValue::Density) >= Layer.Density)
+                    {
+                        continue;
+                    }
+
+                    if (SurvivesSpacing(Seed, CellSize, Layer.MinSpacing, CellX, CellY, Point))
+                    {
+                        Candidates.Points.Add(Point);
+                        Candidates.Cells.Add(FIntPoint(CellX, CellY));
+                    }
+                }
+            }
+
+            // --- Biome filter on this tile's surface ---
+            const int32 NumCandidates = Candidates.Points.Num();
+            TArray<float> Heights;
+            TArray<FVector3f> Normals;
+            Heights.SetNumUninitialized(NumCandidates);
+            Normals.SetNumUninitialized(NumCandidates);
+            HeightQuery.GetHeights(Candidates.Points, Heights);
+            HeightQuery.GetNormals(Candidates.Points, Normals);
+
+            TArray<FTransform>& Out = BandInstances[Band];
+            for (int32 i = 0; i < NumCandidates; ++i)
+            {
+                const float LocalZ = Heights[i] - static_cast<float>(HeightQuery.Transform.GetLocation().Z);
+                const float Height01 = (HeightMultiplier > 0.0f) ? LocalZ / HeightMultiplier : 0.0f;
+                const float Slope = 1.0f - Normals[i].Z;
+
+                if (Height01 < Layer.HeightRange.X || Height01 > Layer.HeightRange.Y ||
+                    Slope < Layer.SlopeRange.X || Slope > Layer.SlopeRange.Y)
+                {
+                    continue;
+                }
+
+                const FIntPoint& Cell = Candidates.Cells[i];
+                const float Yaw = HashCell01(Seed, Cell.X, Cell.Y, ECellValue::Yaw) * 360.0f;
+                const float Scale = FMath::Lerp(Layer.ScaleRange.X, Layer.ScaleRange.Y, HashCell01(Seed, Cell.X, Cell.Y, ECellValue::Scale));
+
+                const FVector Up = FVector::UpVector;
+                const FVector Tilted = FMath::Lerp(Up, FVector(Normals[i]), Layer.AlignToNormal).GetSafeNormal(UE_SMALL_NUMBER, Up);
+                const FQuat Rotation = FQuat::FindBetweenNormals(Up, Tilted) * FQuat(Up, FMath::DegreesToRadians(Yaw));
+
+                const FVector2D Local = Candidates.Points[i] - Settings.WorldOrigin;
+                Out.Emplace(Rotation, FVector(Local.X, Local.Y, LocalZ - Layer.SinkDepth), FVector(Scale));
+            }
+        });
+
+        // Band order is row order, whatever ran first
+        TArray<FTransform>& LayerInstances = OutResult.Instances[LayerIndex];
+        int32 NumInstances = 0;
+        for (const TArray<FTransform>& Band : BandInstances)
+        {
+            NumInstances += Band.Num();
+        }
+        LayerInstances.Reserve(NumInstances);
+        for (TArray<FTransform>& Band : BandInstances)
+        {
+            LayerInstances.Append(MoveTemp(Band));
+        }
+    }
+}
@@ -0,0 +1,114 @@
+// TerrainScatter.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TerrainScatter.generated.h"
+
+class UStaticMesh;
+struct FTerrainHeightQuery;
+
+// One kind of instance scattered over a landmass (e.g. the
+// Stylized_Spruce_Forest spruces), with the height and slope ranges of the
+// biome it grows in. Ranges follow FTerrainType: normalized height, and slope
+// from 0 (flat) to 1 (vertical).
+USTRUCT(BlueprintType)
+struct FTerrainScatterLayer
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, Category = "Scatter")
+    UStaticMesh* Mesh = nullptr;
+
+    // No two instances of this layer are closer than this (world units)
+    UPROPERTY(EditAnywhere, Category = "Scatter", meta = (ClampMin = "10.0"))
+    float MinSpacing = 800.0f;
+
+    // Fraction of the spaced points kept, before the biome filter
+    UPROPERTY(EditAnywhere, Category = "Scatter", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+    float Density = 1.0f;
+
+    UPROPERTY(EditAnywhere, Category = "Scatter|Biome", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+    float MinHeight = 0.25f;
+
+    UPROPERTY(EditAnywhere, Category = "Scatter|Biome", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+    float MaxHeight = 0.7f;
+
+    UPROPERTY(EditAnywhere, Category = "Scatter|Biome", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+    float MinSlope = 0.0f;
+
+    UPROPERTY(EditAnywhere, Category = "Scatter|Biome", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+    float MaxSlope = 0.35f;
+
+    // Uniform scale picked per instance in [X, Y]
+    UPROPERTY(EditAnywhere, Category = "Scatter|Placement")
+    FVector2D ScaleRange = FVector2D(0.8, 1.2);
+
+    // 0 keeps instances upright, 1 tilts them fully onto the surface normal
+    UPROPERTY(EditAnywhere, Category = "Scatter|Placement", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+    float AlignToNormal = 0.0f;
+
+    // Pushes instances into the ground so trunks don't float on slopes
+    UPROPERTY(EditAnywhere, Category = "Scatter|Placement")
+    float SinkDepth = 20.0f;
+
+    // Instances are hidden beyond this distance (0 = never)
+    UPROPERTY(EditAnywhere, Category = "Scatter|Rendering", meta = (ClampMin = "0"))
+    int32 CullDistance = 30000;
+
+    // Per-instance physics bodies are created on the game thread, so collision is opt-in
+    UPROPERTY(EditAnywhere, Category = "Scatter|Rendering")
+    bool bCollision = false;
+};
+
+// The parts of a layer the worker needs, without the UObject references
+struct PCG_EXPLORATION_UE_API FTerrainScatterLayerParams
+{
+    float     MinSpacing = 800.0f;
+    float     Density = 1.0f;
+    FVector2f HeightRange = FVector2f(0.0f, 1.0f);
+    FVector2f SlopeRange = FVector2f(0.0f, 1.0f);
+    FVector2f ScaleRange = FVector2f(1.0f, 1.0f);
+    float     AlignToNormal = 0.0f;
+    float     SinkDepth = 0.0f;
+
+    explicit FTerrainScatterLayerParams(const FTerrainScatterLayer& Layer);
+    FTerrainScatterLayerParams() = default;
+};
+
+struct PCG_EXPLORATION_UE_API FTerrainScatterSettings
+{
+    TArray<FTerrainScatterLayerParams> Layers;
+    int32 Seed = 0;
+
+    // World XY of heightmap sample (0, 0). Points are generated in world
+    // space so neighbouring tiles agree; instances come out relative to this.
+    FVector2D WorldOrigin = FVector2D::ZeroVector;
+
+    // Cell rows handed to each task
+    int32 RowsPerBand = 8;
+};
+
+// Component-space instance transforms, one array per layer
+struct PCG_EXPLORATION_UE_API FTerrainScatterResult
+{
+    TArray<TArray<FTransform>> Instances;
+
+    int32 GetNumInstances() const;
+};
+
+namespace TerrainScatter
+{
+    // Blue-noise points over the heightmap, filtered per layer by height,
+    // slope and density.
+    //
+    // Points come from a world-aligned grid with one hashed candidate per
+    // cell; a candidate survives if it outranks (by hashed priority) every
+    // other candidate within MinSpacing. That depends only on world cell
+    // coordinates and the seed, never on which tile asks, so tiles produce
+    // the same points along shared edges and each point belongs to exactly
+    // one tile. Biome and density filters run after spacing, on the owning
+    // tile's heights. Rows of cells run in parallel; the result does not
+    // depend on the band split.
+    PCG_EXPLORATION_UE_API void Build(const FTerrainScatterSettings& Settings, const FTerrainHeightQuery& HeightQuery, FTerrainScatterResult& OutResult);
+}
@@ -0,0 +1,46 @@
+// TerrainStats.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+// "stat ProceduralTerrain" in game; the ProceduralTerrain trace channel in
+// Insights (-trace=cpu,ProceduralTerrain, or "Trace.Enable ProceduralTerrain")
+DECLARE_STATS_GROUP(TEXT("Procedural Terrain"), STATGROUP_ProceduralTerrain, STATCAT_Advanced);
+
+// ------------ Stage timings ------------
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Noise"),             STAT_Terrain_Noise,          STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Height Cache"),      STAT_Terrain_HeightCache,    STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Erosion"),           STAT_Terrain_Erosion,        STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hydrology"),         STAT_Terrain_Hydrology,      STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Vertex Build"),      STAT_Terrain_VertexBuild,    STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Index Build"),       STAT_Terrain_IndexBuild,     STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Normals"),           STAT_Terrain_Normals,        STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Section Upload"),    STAT_Terrain_SectionUpload,  STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Collision"),         STAT_Terrain_Collision,      STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Material Instance"), STAT_Terrain_Material,       STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Water Update"),      STAT_Terrain_Water,          STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Scatter"),           STAT_Terrain_Scatter,        STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Scatter Commit"),    STAT_Terrain_ScatterCommit,  STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+
+// ------------ Counters ------------
+// Totals over every committed landmass, kept current as tiles rebuild or go away
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Vertices"),    STAT_Terrain_Vertices,   STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Triangles"),   STAT_Terrain_Triangles,  STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Tiles Alive"), STAT_Terrain_TilesAlive, STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Section Memory"),         STAT_Terrain_SectionMemory, STATGROUP_ProceduralTerrain, PCG_EXPLORATION_UE_API);
+
+UE_TRACE_CHANNEL_EXTERN(ProceduralTerrainChannel, PCG_EXPLORATION_UE_API);
+
+// Times a stage in both systems: the cycle stat for "stat ProceduralTerrain"
+// and a named CPU event on ProceduralTerrainChannel for Insights
+#define TERRAIN_STAGE_SCOPE(Stage) \
+    SCOPE_CYCLE_COUNTER(STAT_Terrain_##Stage); \
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("Terrain::" #Stage, ProceduralTerrainChannel)
+
+// Trace-only scope for finer work items (row bands, single LODs)
+#define TERRAIN_TRACE_SCOPE(Name) \
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("Terrain::" Name, ProceduralTerrainChannel)
@@ -5,9 +5,11 @@
 //-----------------------------------------------------------------------------
 
 #include "ProceduralLandmass.h"
+#include "TerrainNoise.h"
 #include "ProceduralMeshComponent.h"
 #include "Materials/MaterialInterface.h"
 #include "Math/UnrealMathUtility.h"
+#include "Math/VectorRegister.h"
 
 // Sets default values
 AProceduralLandmass::AProceduralLandmass()
@@ -139,6 +141,14 @@ void AProceduralLandmass::GenerateTerrain()
         ProceduralMesh->SetMaterial(0, TerrainMaterial);
     }
 
+    // Rebake only when the biome settings differ from the ones baked
+    const uint32 BiomeHash = GetBiomeSettingsHash();
+    if (BiomeColorLUT.Num() == 0 || BiomeHash != BiomeColorLUTHash)
+    {
+        BuildBiomeColorLUT();
+        BiomeColorLUTHash = BiomeHash;
+    }
+
     // 1) Build a height map using multi-octave Perlin noise
     TArray<float> HeightMap;
     GenerateNoiseMap(HeightMap);
@@ -175,49 +185,27 @@ void AProceduralLandmass::GenerateNoiseMap(TArray<float>& OutHeightMap)
         OctaveOffsets[i] = FVector2D(OffsetX, OffsetY);
     }
 
+    // Centred on the map, with each octave shifted by its own offset. The
+    // sampler evaluates four columns per step through the vector kernel.
+    FTerrainNoiseSampler Sampler;
+    Sampler.MapWidth = MapWidth;
+    Sampler.BaseWorldX = -static_cast<float>(MapWidth) / 2.0f;
+    Sampler.BaseWorldY = -static_cast<float>(MapHeight) / 2.0f;
+    Sampler.NoiseScale = NoiseScale;
+    Sampler.Octaves = NumOctaves;
+    Sampler.Persistence = Persistance;
+    Sampler.Lacunarity = Lacunarity;
+    Sampler.OctaveOffsets = MoveTemp(OctaveOffsets);
+    Sampler.BuildRows(0, MapHeight, OutHeightMap.GetData());
+
+    // The sampler's fixed [0,1] mapping is affine in the octave sum, so
+    // stretching its min..max gives the same map as stretching the raw sums
     float MaxNoiseHeight = TNumericLimits<float>::Lowest();
     float MinNoiseHeight = TNumericLimits<float>::Max();
-
-    const float HalfWidth = static_cast<float>(MapWidth) / 2.0f;
-    const float HalfHeight = static_cast<float>(MapHeight) / 2.0f;
-
-    // Compute raw noise heights
-    for (int32 y = 0; y < MapHeight; ++y)
+    for (const float NoiseHeight : OutHeightMap)
     {
-        for (int32 x = 0; x < MapWidth; ++x)
-        {
-            float Amplitude = 1.0f;
-            float Frequency = 1.0f;
-            float NoiseHeight = 0.0f;
-
-            for (int32 i = 0; i < NumOctaves; ++i)
-            {
-                const float SampleX =
-                    ((static_cast<float>(x) - HalfWidth) / NoiseScale) * Frequency + OctaveOffsets[i].X;
-
-                const float SampleY =
-                    ((static_cast<float>(y) - HalfHeight) / NoiseScale) * Frequency + OctaveOffsets[i].Y;
-
-                const float PerlinValue = FMath::PerlinNoise2D(FVector2D(SampleX, SampleY)); // [-1,1]
-
-                NoiseHeight += PerlinValue * Amplitude;
-
-                Amplitude *= Persistance;
-                Frequency *= Lacunarity;
-            }
-
-            const int32 Index = x + y * MapWidth;
-            OutHeightMap[Index] = NoiseHeight;
-
-            if (NoiseHeight > MaxNoiseHeight)
-            {
-                MaxNoiseHeight = NoiseHeight;
-            }
-            if (NoiseHeight < MinNoiseHeight)
-            {
-                MinNoiseHeight = NoiseHeight;
-            }
-        }
+        MaxNoiseHeight = FMath::Max(MaxNoiseHeight, NoiseHeight);
+        MinNoiseHeight = FMath::Min(MinNoiseHeight, NoiseHeight);
     }
 
     // Normalize heights to [0,1]
@@ -326,6 +314,83 @@ FLinearColor AProceduralLandmass::GetColorForHeightAndSlope(float NormalizedHeig
     }
 }
 
+void AProceduralLandmass::BuildBiomeColorLUT()
+{
+    BiomeColorLUT.SetNumUninitialized(BiomeLUTHeightSize * BiomeLUTSlopeSize);
+
+    // Cells sit on exact grid points, so the table reproduces the biome
+    // lookup at every sample and only interpolates between them
+    for (int32 s = 0; s < BiomeLUTSlopeSize; ++s)
+    {
+        const float Slope = static_cast<float>(s) / static_cast<float>(BiomeLUTSlopeSize - 1);
+
+        for (int32 h = 0; h < BiomeLUTHeightSize; ++h)
+        {
+            const float NormalizedHeight = static_cast<float>(h) / static_cast<float>(BiomeLUTHeightSize - 1);
+            BiomeColorLUT[s * BiomeLUTHeightSize + h] = GetColorForHeightAndSlope(NormalizedHeight, Slope);
+        }
+    }
+}
+
+uint32 AProceduralLandmass::GetBiomeSettingsHash() const
+{
+    uint32 Hash = GetTypeHash(HeightBlendRange);
+    for (const FTerrainType& Type : TerrainTypes)
+    {
+        Hash = HashCombine(Hash, GetTypeHash(Type.Height));
+        Hash = HashCombine(Hash, GetTypeHash(Type.MinSlope));
+        Hash = HashCombine(Hash, GetTypeHash(Type.MaxSlope));
+        Hash = HashCombine(Hash, GetTypeHash(Type.Color));
+    }
+    return Hash;
+}
+
+void AProceduralLandmass::SampleBiomeColorLUT(const float* Heights, const float* Slopes, int32 Num, FLinearColor* OutColors) const
+{
+    // Linear along height, where biomes blend; nearest along slope, where
+    // biome ranges are hard cut-offs. No branches on the biome data.
+    const VectorRegister4Float Zero = VectorZeroFloat();
+    const VectorRegister4Float One = VectorOneFloat();
+    const VectorRegister4Float HeightScale = VectorSetFloat1(static_cast<float>(BiomeLUTHeightSize - 1));
+    const VectorRegister4Float SlopeScale = VectorSetFloat1(static_cast<float>(BiomeLUTSlopeSize - 1));
+    const VectorRegister4Float MaxH0 = VectorSetFloat1(static_cast<float>(BiomeLUTHeightSize - 2));
+    const VectorRegister4Float RowStride = VectorSetFloat1(static_cast<float>(BiomeLUTHeightSize));
+    const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+
+    alignas(16) float HeightLanes[4];
+    alignas(16) float SlopeLanes[4];
+    alignas(16) float CellLanes[4];
+    alignas(16) float AlphaLanes[4];
+
+    for (int32 First = 0; First < Num; First += 4)
+    {
+        // The tail repeats the last vertex and is discarded on store
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            const int32 i = FMath::Min(First + Lane, Num - 1);
+            HeightLanes[Lane] = Heights[i];
+            SlopeLanes[Lane] = Slopes[i];
+        }
+
+        const VectorRegister4Float HeightCoord = VectorMultiply(VectorMin(VectorMax(VectorLoadAligned(HeightLanes), Zero), One), HeightScale);
+        const VectorRegister4Float H0 = VectorMin(VectorFloor(HeightCoord), MaxH0);
+        const VectorRegister4Float Row = VectorFloor(VectorMultiplyAdd(VectorMin(VectorMax(VectorLoadAligned(SlopeLanes), Zero), One), SlopeScale, Half));
+
+        // Cell indices stay below 2^24, so they are exact as floats
+        VectorStoreAligned(VectorMultiplyAdd(Row, RowStride, H0), CellLanes);
+        VectorStoreAligned(VectorSubtract(HeightCoord, H0), AlphaLanes);
+
+        const int32 Count = FMath::Min(4, Num - First);
+        for (int32 Lane = 0; Lane < Count; ++Lane)
+        {
+            const FLinearColor* Cell = BiomeColorLUT.GetData() + static_cast<int32>(CellLanes[Lane]);
+            const VectorRegister4Float C0 = VectorLoad(&Cell[0].R);
+            const VectorRegister4Float C1 = VectorLoad(&Cell[1].R);
+            VectorStore(VectorMultiplyAdd(VectorSubtract(C1, C0), VectorSetFloat1(AlphaLanes[Lane]), C0), &OutColors[First + Lane].R);
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 // Mesh generation
 //-----------------------------------------------------------------------------
@@ -341,13 +406,14 @@ void AProceduralLandmass::CreateMeshFromHeightMap(const TArray<float>& HeightMap
     TArray<FVector2D> UVs;
     TArray<FLinearColor> VertexColors;
     TArray<FProcMeshTangent> Tangents;
+    TArray<float> Slopes;
 
     const int32 NumVerts = NumVertsX * NumVertsY;
 
     Vertices.Reserve(NumVerts);
     Normals.Reserve(NumVerts);
     UVs.Reserve(NumVerts);
-    VertexColors.Reserve(NumVerts);
+    Slopes.Reserve(NumVerts);
 
     const float HalfWidth = static_cast<float>(NumVertsX - 1) * GridSize * 0.5f;
     const float HalfHeight = static_cast<float>(NumVertsY - 1) * GridSize * 0.5f;
@@ -397,13 +463,14 @@ void AProceduralLandmass::CreateMeshFromHeightMap(const TArray<float>& HeightMap
             Normals.Add(Normal);
 
             // Slope metric: 0 = flat, 1 = vertical
-            const float Slope = 1.0f - FVector::DotProduct(Normal, FVector::UpVector);
-
-            // Pick biome color based on height + slope
-            VertexColors.Add(GetColorForHeightAndSlope(NoiseValue, Slope));
+            Slopes.Add(1.0f - FVector::DotProduct(Normal, FVector::UpVector));
         }
     }
 
+    // Pick biome colors based on height + slope, four vertices at a time
+    VertexColors.SetNumUninitialized(NumVerts);
+    SampleBiomeColorLUT(HeightMap.GetData(), Slopes.GetData(), NumVerts, VertexColors.GetData());
+
     // Build triangles (two per quad in the grid)
     Triangles.Reserve((NumVertsX - 1) * (NumVertsY - 1) * 6);
 
@@ -117,4 +117,22 @@ private:
     void GenerateNoiseMap(TArray<float>& OutHeightMap);
     void CreateMeshFromHeightMap(const TArray<float>& HeightMap);
     FLinearColor GetColorForHeightAndSlope(float NormalizedHeight, float Slope) const;
+
+    // Bakes GetColorForHeightAndSlope over a height x slope grid, so per-vertex
+    // coloring is one table read no matter how many biomes are defined
+    void BuildBiomeColorLUT();
+    uint32 GetBiomeSettingsHash() const;
+
+    // Colors Num vertices from the table, four per step
+    void SampleBiomeColorLUT(const float* Heights, const float* Slopes, int32 Num, FLinearColor* OutColors) const;
+
+    static constexpr int32 BiomeLUTHeightSize = 256;
+    static constexpr int32 BiomeLUTSlopeSize = 64;
+
+    // Row-major, one row per slope step
+    TArray<FLinearColor> BiomeColorLUT;
+
+    // GetBiomeSettingsHash() the table was baked from; compared on every
+    // GenerateTerrain, so undo, Blueprint and runtime edits are all caught
+    uint32 BiomeColorLUTHash = 0;
 };